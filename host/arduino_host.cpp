@@ -0,0 +1,92 @@
+// Host implementation of the Arduino stand-ins in host/include. Time is the steady clock
+// since start-up, input pins read the levels set with arduino_host_set_pin().
+
+#include "arduino_host.h"
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include <chrono>
+#include <thread>
+
+#include "esp_idf_host.h"
+
+using host_clock = std::chrono::steady_clock;
+
+constexpr int PIN_COUNT = 64;
+
+static const host_clock::time_point start_time = host_clock::now();
+static uint8_t pin_levels[PIN_COUNT];
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+unsigned long millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(host_clock::now() - start_time).count();
+}
+
+unsigned long micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(host_clock::now() - start_time).count();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < PIN_COUNT && mode == INPUT_PULLUP) {
+    pin_levels[pin] = HIGH;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < PIN_COUNT ? pin_levels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  arduino_host_set_pin(pin, val);
+}
+
+void arduino_host_set_pin(uint8_t pin, uint8_t level) {
+  if (pin < PIN_COUNT) {
+    pin_levels[pin] = level;
+  }
+}
+
+void HardwareSerial::begin(unsigned long baud) {}
+
+size_t HardwareSerial::print(const char* str) {
+  return fputs(str, stdout) < 0 ? 0 : strlen(str);
+}
+
+size_t HardwareSerial::println(const char* str) {
+  return print(str) + print("\n");
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int written = vprintf(format, args);
+  va_end(args);
+  return written < 0 ? 0 : written;
+}
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  clock = settings.clock;
+}
+
+void SPIClass::endTransaction() {}
+
+void SPIClass::transferBytes(const uint8_t* data, uint8_t* out, uint32_t size) {
+  std::this_thread::sleep_for(std::chrono::nanoseconds((uint64_t)size * 8 * 1000000000ull / clock));
+  esp_host_spi_bytes(data, size);
+  if (out) {
+    memset(out, 0, size);
+  }
+}
@@ -0,0 +1,10 @@
+// Controls for the host Arduino stand-ins
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Sets the level digitalRead() returns for a pin, e.g. LOW for a pressed button.
+ */
+void arduino_host_set_pin(uint8_t pin, uint8_t level);
@@ -0,0 +1,101 @@
+// Runs the unmodified device sketch (orbitris_esp32.ino) on the host Arduino stand-ins,
+// with its own frame pacing. Button A is pressed on a scripted frame to start a game,
+// and the bus is decoded by the panel emulator, whose image --dump saves on exit.
+// --record FILE captures the frame handed to lcd_update() by every loop().
+
+#include <Arduino.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../orbitris_esp32/input.h"
+#include "../orbitris_esp32/sharp_display.h"
+#include "arduino_host.h"
+#include "esp_idf_host.h"
+#include "frame_record.h"
+#include "sharp_emulator.h"
+
+constexpr int DEFAULT_FRAMES = 300;
+constexpr int START_GAME_FRAME = 30;
+constexpr uint32_t SPI_CLOCK_HZ = 10000000;  // SPI_CLOCK_HZ in sharp_display.cpp
+constexpr int LCD_CS_GPIO = 21;              // PIN_NUM_CS in sharp_display.cpp
+
+void setup();
+void loop();
+
+static void on_gpio_level(int gpio_num, uint32_t level) {
+  if (gpio_num == LCD_CS_GPIO) {
+    sharp_emu_set_cs(level);
+  }
+}
+
+int main(int argc, char const *argv[]) {
+  int frames = DEFAULT_FRAMES;
+  const char* dump_path = nullptr;
+  const char* record_path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      dump_path = argv[++i];
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    }
+  }
+
+  if (record_path && !frame_recorder_open(record_path)) {
+    fprintf(stderr, "can't write %s\n", record_path);
+    return 1;
+  }
+
+  sharp_emu_init(SPI_CLOCK_HZ);
+  esp_host_on_gpio_level(on_gpio_level);
+  esp_host_on_spi_bytes(sharp_emu_receive);
+
+  setup();
+
+  unsigned long start_us = micros();
+  for (int frame = 1; frame <= frames; frame++) {
+    arduino_host_set_pin(ESP_KEY_A, frame == START_GAME_FRAME ? LOW : HIGH);
+    loop();
+
+    // Nothing draws between lcd_update() and the end of loop(). Strip mode has no
+    // framebuffer, the frame is taken from the emulated panel once it is sent.
+    if (record_path) {
+      static uint8_t frame[FRAME_RECORD_SIZE];
+#if LCD_STRIP_LINES > 0
+      lcd_wait_update();
+#endif
+      for (int y = 0; y < LCD_HEIGHT; y++) {
+#if LCD_STRIP_LINES > 0
+        memcpy(&frame[y * FRAME_RECORD_BYTES_PER_LINE], sharp_emu_get_line(y), FRAME_RECORD_BYTES_PER_LINE);
+#else
+        lcd_read_line(y, &frame[y * FRAME_RECORD_BYTES_PER_LINE]);
+#endif
+      }
+      frame_recorder_add(frame);
+    }
+  }
+  unsigned long elapsed_us = micros() - start_us;
+  lcd_deinit();
+
+  const SharpEmuStats& emu = sharp_emu_get_stats();
+  if (frames > 0) {
+    fprintf(stderr, "%d frames, avg %lu us, %llu us bus time/frame, %u protocol errors\n", frames,
+            elapsed_us / frames, (unsigned long long)(emu.bus_time_ns / 1000 / frames),
+            (unsigned)emu.protocol_errors);
+  }
+
+  if (record_path && !frame_recorder_close()) {
+    fprintf(stderr, "can't write %s\n", record_path);
+    return 1;
+  }
+
+  if (dump_path && !sharp_emu_write_pbm(dump_path)) {
+    fprintf(stderr, "can't write %s\n", dump_path);
+    return 1;
+  }
+
+  return emu.protocol_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+#include "band_raster.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../orbitris_esp32/const.h"
+#include "../orbitris_esp32/display_list.h"
+#include "../orbitris_esp32/game_main.h"
+
+extern void lcd_set_clip_lines(int first, int count);
+
+static std::vector<std::thread> workers;
+static int band_count = 1;
+static int band_lines = LCD_HEIGHT;
+
+static std::mutex mutex;
+static std::condition_variable start_cv;
+static std::condition_variable done_cv;
+// Bumped for every frame, workers draw once per generation
+static unsigned generation = 0;
+static int pending_bands = 0;
+static bool stopping = false;
+
+static void draw_band(int band) {
+  // Lines outside the frame's damage keep the previous frame
+  int damage_first = 0;
+  int damage_count = 0;
+  get_frame_damage_lines(&damage_first, &damage_count);
+  int top = std::max(band * band_lines, damage_first);
+  int bottom = std::min((band + 1) * band_lines, damage_first + damage_count);
+  if (bottom > top) {
+    lcd_set_clip_lines(top, bottom - top);
+    display_list_replay();
+  }
+}
+
+static void band_worker(int band, unsigned drawn_generation) {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      start_cv.wait(lock, [&] { return stopping || generation != drawn_generation; });
+      if (stopping) {
+        return;
+      }
+      drawn_generation = generation;
+    }
+
+    draw_band(band);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pending_bands == 0) {
+      done_cv.notify_one();
+    }
+  }
+}
+
+void band_raster_init(int threads) {
+  band_raster_shutdown();
+
+  // Whole BAND_RASTER_ALIGN line blocks per band, rounded up
+  int blocks = (LCD_HEIGHT + BAND_RASTER_ALIGN - 1) / BAND_RASTER_ALIGN;
+  int blocks_per_band = (blocks + std::max(threads, 1) - 1) / std::max(threads, 1);
+  band_lines = blocks_per_band * BAND_RASTER_ALIGN;
+  band_count = (LCD_HEIGHT + band_lines - 1) / band_lines;
+
+  for (int band = 1; band < band_count; band++) {
+    workers.emplace_back(band_worker, band, generation);
+  }
+}
+
+void band_raster_shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  start_cv.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  stopping = false;
+  band_count = 1;
+  band_lines = LCD_HEIGHT;
+}
+
+void band_raster_draw() {
+  if (display_list_overflowed()) {
+    draw_frame();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    generation++;
+    pending_bands = band_count - 1;
+  }
+  start_cv.notify_all();
+
+  draw_band(0);
+  lcd_set_clip_lines(0, LCD_HEIGHT);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_cv.wait(lock, [] { return pending_bands == 0; });
+}
@@ -0,0 +1,29 @@
+// Parallel rasterization of recorded frames for the host builds. The framebuffer is split
+// into horizontal bands, one per worker thread, and each worker replays the whole display
+// list with drawing clipped to its band (lcd_set_clip_lines()), so every pixel is written
+// by the same draw calls in the same order as by a single display_list_replay(): the
+// result is bit-identical. Bands start on multiples of BAND_RASTER_ALIGN lines, which keeps
+// the device driver's per-32-line dirty bitmap words to one thread each.
+
+#pragma once
+
+constexpr int BAND_RASTER_ALIGN = 32;
+
+/**
+ * @brief Starts the workers. The calling thread draws the first band itself, so threads - 1
+ * are started. Fewer bands than threads are used if the screen has fewer aligned bands.
+ */
+void band_raster_init(int threads);
+
+/**
+ * @brief Stops and joins the workers.
+ */
+void band_raster_shutdown();
+
+/**
+ * @brief Draws the recorded frame (see display_list.h) band by band on all threads and
+ * returns when every band is done. Like draw_frame(), only draws the frame's damaged
+ * lines. Falls back to draw_frame() on the calling thread if the
+ * frame didn't fit in the display list.
+ */
+void band_raster_draw();
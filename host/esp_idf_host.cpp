@@ -0,0 +1,157 @@
+// Host stand-ins for the ESP-IDF drivers used by the device LCD code. Queued SPI
+// transactions are "sent" by a worker thread that sleeps for the time the bytes would
+// take on the bus at the configured clock, so a frame drawn while DMA is busy overlaps
+// with the transfer the same way it does on the device.
+
+#include "esp_idf_host.h"
+
+#include <driver/gpio.h>
+#include <driver/spi_master.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using bus_clock = std::chrono::steady_clock;
+
+struct queued_transaction_t {
+  spi_transaction_t* transaction;
+  bus_clock::time_point queued_at;
+};
+
+struct spi_device_t {
+  spi_device_interface_config_t config;
+  std::mutex mutex;
+  std::condition_variable queued_cv;
+  std::condition_variable done_cv;
+  std::deque<queued_transaction_t> queued;
+  std::deque<spi_transaction_t*> done;
+  std::thread worker;
+  bool removing = false;  // set by spi_bus_remove_device(), the worker finishes the queue and exits
+};
+
+static std::atomic<uint32_t> spi_clock_override{0};
+static std::atomic<esp_host_spi_bytes_cb_t> spi_bytes_cb{nullptr};
+static std::atomic<esp_host_gpio_level_cb_t> gpio_level_cb{nullptr};
+
+static void spi_worker(spi_device_t* device) {
+  bus_clock::time_point bus_free_at = bus_clock::now();
+  for (;;) {
+    queued_transaction_t entry;
+    {
+      std::unique_lock<std::mutex> lock(device->mutex);
+      device->queued_cv.wait(lock, [device] { return device->removing || !device->queued.empty(); });
+      if (device->queued.empty()) {
+        return;
+      }
+      entry = device->queued.front();
+      device->queued.pop_front();
+    }
+    spi_transaction_t* transaction = entry.transaction;
+
+    // Transactions queued back to back follow each other on the bus without a gap. The
+    // start is taken from the queue time rather than from when the worker woke up, so
+    // oversleeping one transaction doesn't delay all the following ones.
+    uint32_t clock_hz = spi_clock_override ? spi_clock_override.load() : device->config.clock_speed_hz;
+    auto bus_time = std::chrono::nanoseconds((uint64_t)transaction->length * 1000000000ull / clock_hz);
+    bus_free_at = std::max(bus_free_at, entry.queued_at) + bus_time;
+    std::this_thread::sleep_until(bus_free_at);
+
+    const uint8_t* data = (transaction->flags & SPI_TRANS_USE_TXDATA) ? transaction->tx_data
+                                                                      : (const uint8_t*)transaction->tx_buffer;
+    esp_host_spi_bytes(data, transaction->length / 8);
+
+    if (device->config.post_cb) {
+      device->config.post_cb(transaction);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(device->mutex);
+      device->done.push_back(transaction);
+    }
+    device->done_cv.notify_one();
+  }
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t* bus_config, spi_dma_chan_t dma_chan) {
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config, spi_device_handle_t* handle) {
+  spi_device_t* device = new spi_device_t();
+  device->config = *dev_config;
+  device->worker = std::thread(spi_worker, device);
+  *handle = device;
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+  {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->removing = true;
+  }
+  handle->queued_cv.notify_one();
+  handle->worker.join();
+  delete handle;
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id) {
+  return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t ticks_to_wait) {
+  {
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->queued.push_back({trans_desc, bus_clock::now()});
+  }
+  handle->queued_cv.notify_one();
+  return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc, TickType_t ticks_to_wait) {
+  std::unique_lock<std::mutex> lock(handle->mutex);
+  handle->done_cv.wait(lock, [handle] { return !handle->done.empty(); });
+  *trans_desc = handle->done.front();
+  handle->done.pop_front();
+  return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+  esp_host_gpio_level_cb_t on_level = gpio_level_cb;
+  if (on_level) {
+    on_level(gpio_num, level);
+  }
+  return ESP_OK;
+}
+
+void esp_host_set_spi_clock(uint32_t clock_hz) {
+  spi_clock_override = clock_hz;
+}
+
+void esp_host_spi_bytes(const uint8_t* data, size_t len) {
+  esp_host_spi_bytes_cb_t on_bytes = spi_bytes_cb;
+  if (on_bytes) {
+    on_bytes(data, len);
+  }
+}
+
+void esp_host_on_spi_bytes(esp_host_spi_bytes_cb_t callback) {
+  spi_bytes_cb = callback;
+}
+
+void esp_host_on_gpio_level(esp_host_gpio_level_cb_t callback) {
+  gpio_level_cb = callback;
+}
@@ -0,0 +1,32 @@
+// Hooks into the host ESP-IDF stand-ins, used to attach the panel emulator to the bus
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+typedef void (*esp_host_spi_bytes_cb_t)(const uint8_t* data, size_t len);
+typedef void (*esp_host_gpio_level_cb_t)(int gpio_num, uint32_t level);
+
+/**
+ * @brief Overrides the clock of every SPI device for the simulated transfers.
+ * @param clock_hz Clock in Hz, 0 to use the one the device was added with.
+ */
+void esp_host_set_spi_clock(uint32_t clock_hz);
+
+/**
+ * @brief Sets a callback for the bytes of each transaction, called from the SPI worker
+ * thread once the transfer time has passed, before the transaction's post_cb.
+ */
+void esp_host_on_spi_bytes(esp_host_spi_bytes_cb_t callback);
+
+/**
+ * @brief Passes bytes sent outside of the ESP-IDF driver to the esp_host_on_spi_bytes()
+ * callback, if any.
+ */
+void esp_host_spi_bytes(const uint8_t* data, size_t len);
+
+/**
+ * @brief Sets a callback for gpio_set_level(), called from the thread setting the level.
+ */
+void esp_host_on_gpio_level(esp_host_gpio_level_cb_t callback);
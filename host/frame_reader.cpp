@@ -0,0 +1,161 @@
+#include "frame_record.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+template <typename T>
+static T read_le(const uint8_t* data) {
+  T value = 0;
+  for (size_t i = 0; i < sizeof(T); i++) {
+    value |= (T)data[i] << (i * 8);
+  }
+  return value;
+}
+
+static bool get_varint(const uint8_t*& in, const uint8_t* end, uint32_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 32 && in < end; shift += 7) {
+    uint8_t byte = *in++;
+    value |= (uint32_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t record_offset(const FrameReader& reader, uint32_t frame_number) {
+  return read_le<uint64_t>(&reader.index[frame_number * sizeof(uint64_t)]);
+}
+
+/**
+ * @brief Returns a record whose 5-byte header and payload lie within the file, nullptr if
+ * the index points elsewhere.
+ */
+static const uint8_t* get_record(const FrameReader& reader, uint32_t frame_number) {
+  uint64_t offset = record_offset(reader, frame_number);
+  if (offset > reader.size - 5) {
+    return nullptr;
+  }
+
+  const uint8_t* record = reader.data + offset;
+  uint32_t size = read_le<uint32_t>(record + 1);
+  if (size > reader.size - 5 - offset) {
+    return nullptr;
+  }
+  return record;
+}
+
+/**
+ * @brief XORs a record's delta into reader.frame.
+ */
+static bool apply_record(FrameReader& reader, uint32_t frame_number) {
+  const uint8_t* record = get_record(reader, frame_number);
+  if (!record) {
+    return false;
+  }
+
+  uint32_t size = read_le<uint32_t>(record + 1);
+
+  if (record[0] == FRAME_RECORD_KEY) {
+    memset(reader.frame, 0xff, sizeof(reader.frame));
+  }
+
+  const uint8_t* in = record + 5;
+  const uint8_t* end = in + size;
+  uint32_t pos = 0;
+  while (pos < FRAME_RECORD_SIZE) {
+    uint32_t zeros, literals;
+    if (!get_varint(in, end, zeros) || !get_varint(in, end, literals) ||
+        (uint64_t)pos + zeros + literals > FRAME_RECORD_SIZE || literals > (uint32_t)(end - in)) {
+      return false;
+    }
+
+    pos += zeros;
+    for (uint32_t i = 0; i < literals; i++) {
+      reader.frame[pos++] ^= *in++;
+    }
+  }
+  return true;
+}
+
+bool frame_reader_open(FrameReader& reader, const char* path) {
+  reader.data = nullptr;
+  reader.frame_number = -1;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < FRAME_RECORD_HEADER_SIZE + FRAME_RECORD_FOOTER_SIZE) {
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  reader.data = (const uint8_t*)data;
+  reader.size = st.st_size;
+
+  const uint8_t* footer = reader.data + reader.size - FRAME_RECORD_FOOTER_SIZE;
+  reader.frame_count = read_le<uint32_t>(footer);
+  uint64_t index_offset = read_le<uint64_t>(footer + 4);
+  reader.keyframe_interval = read_le<uint32_t>(reader.data + 12);
+  reader.index = reader.data + index_offset;
+
+  bool valid = memcmp(reader.data, FRAME_RECORD_MAGIC, sizeof(FRAME_RECORD_MAGIC)) == 0 &&
+               memcmp(footer + 12, FRAME_RECORD_INDEX_MAGIC, sizeof(FRAME_RECORD_INDEX_MAGIC)) == 0 &&
+               read_le<uint16_t>(reader.data + 8) == LCD_WIDTH &&
+               read_le<uint16_t>(reader.data + 10) == LCD_HEIGHT && reader.keyframe_interval > 0 &&
+               index_offset + (uint64_t)reader.frame_count * sizeof(uint64_t) == reader.size - FRAME_RECORD_FOOTER_SIZE;
+  if (!valid) {
+    frame_reader_close(reader);
+    return false;
+  }
+  return true;
+}
+
+void frame_reader_close(FrameReader& reader) {
+  if (reader.data) {
+    munmap((void*)reader.data, reader.size);
+    reader.data = nullptr;
+  }
+}
+
+const uint8_t* frame_reader_get(FrameReader& reader, uint32_t frame_number) {
+  if (frame_number >= reader.frame_count) {
+    return nullptr;
+  }
+
+  // Continue from the frame already decoded when it is between the keyframe and the target
+  uint32_t keyframe = frame_number - frame_number % reader.keyframe_interval;
+  uint32_t first = keyframe;
+  if (reader.frame_number >= keyframe && reader.frame_number <= frame_number) {
+    first = reader.frame_number + 1;
+  }
+
+  for (uint32_t i = first; i <= frame_number; i++) {
+    if (!apply_record(reader, i)) {
+      reader.frame_number = -1;
+      return nullptr;
+    }
+  }
+
+  reader.frame_number = frame_number;
+  return reader.frame;
+}
+
+uint32_t frame_reader_record_size(const FrameReader& reader, uint32_t frame_number) {
+  const uint8_t* record = frame_number < reader.frame_count ? get_record(reader, frame_number) : nullptr;
+  return record ? read_le<uint32_t>(record + 1) : 0;
+}
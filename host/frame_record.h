@@ -0,0 +1,88 @@
+// Frame recording for perf and regression analysis. Every frame handed to the panel is
+// stored as an XOR delta against the previous one, run-length encoded, with a keyframe
+// (delta against a white screen) every keyframe_interval frames and an index of record
+// offsets at the end of the file.
+//
+// File layout, integers little-endian:
+//   header  "ORBREC1\0", uint16 width, uint16 height, uint32 keyframe_interval
+//   records uint8 type (FRAME_RECORD_KEY / FRAME_RECORD_DELTA), uint32 payload size, payload
+//   index   uint64 record offset per frame
+//   footer  uint32 frame count, uint64 index offset, "ORBIDX1\0"
+//
+// A payload is a sequence of (varint zero run, varint literal count, literal bytes) that
+// expands to exactly FRAME_RECORD_SIZE bytes.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../orbitris_esp32/const.h"
+
+constexpr int FRAME_RECORD_BYTES_PER_LINE = LCD_WIDTH / 8;
+constexpr int FRAME_RECORD_SIZE = FRAME_RECORD_BYTES_PER_LINE * LCD_HEIGHT;
+constexpr uint32_t FRAME_RECORD_DEFAULT_KEYFRAME_INTERVAL = 120;
+
+constexpr uint8_t FRAME_RECORD_KEY = 0;
+constexpr uint8_t FRAME_RECORD_DELTA = 1;
+
+constexpr char FRAME_RECORD_MAGIC[8] = "ORBREC1";
+constexpr char FRAME_RECORD_INDEX_MAGIC[8] = "ORBIDX1";
+constexpr size_t FRAME_RECORD_HEADER_SIZE = 16;
+constexpr size_t FRAME_RECORD_FOOTER_SIZE = 20;
+
+/**
+ * @brief Starts recording to a file, replacing it.
+ * @return false if the file can't be created
+ */
+bool frame_recorder_open(const char* path, uint32_t keyframe_interval = FRAME_RECORD_DEFAULT_KEYFRAME_INTERVAL);
+
+/**
+ * @brief Appends a frame: FRAME_RECORD_SIZE bytes, FRAME_RECORD_BYTES_PER_LINE per line,
+ * leftmost pixel in the most significant bit, 1 for white. Does nothing when not recording.
+ */
+void frame_recorder_add(const uint8_t* frame);
+
+/**
+ * @brief Writes the index and closes the file.
+ * @return false if any write failed
+ */
+bool frame_recorder_close();
+
+bool frame_recorder_is_open();
+
+/**
+ * @brief Memory-mapped recording. Any frame is located through the index in constant
+ * time, and decoded from the keyframe before it, or from the last frame read when that
+ * is closer, so sequential reads cost one delta each.
+ */
+struct FrameReader {
+  const uint8_t* data;
+  size_t size;
+  uint32_t frame_count;
+  uint32_t keyframe_interval;
+  const uint8_t* index;
+  uint8_t frame[FRAME_RECORD_SIZE];
+  int64_t frame_number;  // frame held in `frame`, -1 if none
+};
+
+/**
+ * @brief Maps a recording and checks its header and footer.
+ * @return false if the file can't be mapped or isn't a complete recording
+ */
+bool frame_reader_open(FrameReader& reader, const char* path);
+
+void frame_reader_close(FrameReader& reader);
+
+/**
+ * @brief Decodes a frame.
+ * @return the frame in the format given to frame_recorder_add(), valid until the next
+ * call, or nullptr if the index is out of range or the record is corrupt
+ */
+const uint8_t* frame_reader_get(FrameReader& reader, uint32_t frame_number);
+
+/**
+ * @brief Returns the payload size of a frame record, as stored in the file, or 0 if the
+ * record doesn't fit in the file.
+ */
+uint32_t frame_reader_record_size(const FrameReader& reader, uint32_t frame_number);
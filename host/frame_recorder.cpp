@@ -0,0 +1,144 @@
+#include "frame_record.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static FILE* file = nullptr;
+static uint32_t keyframe_interval = FRAME_RECORD_DEFAULT_KEYFRAME_INTERVAL;
+static uint64_t offset = 0;
+static bool write_failed = false;
+static std::vector<uint64_t> record_offsets;  // file offset of every frame record
+static uint8_t previous[FRAME_RECORD_SIZE];
+static uint8_t delta[FRAME_RECORD_SIZE];
+// Worst case is one literal run over the whole frame
+static uint8_t payload[FRAME_RECORD_SIZE + 16];
+
+static void write_bytes(const void* data, size_t len) {
+  if (fwrite(data, 1, len, file) != len) {
+    write_failed = true;
+  }
+  offset += len;
+}
+
+template <typename T>
+static void write_le(T value) {
+  uint8_t bytes[sizeof(T)];
+  for (size_t i = 0; i < sizeof(T); i++) {
+    bytes[i] = (uint8_t)(value >> (i * 8));
+  }
+  write_bytes(bytes, sizeof(bytes));
+}
+
+static uint8_t* put_varint(uint8_t* out, uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (uint8_t)value;
+  return out;
+}
+
+/**
+ * @brief Encodes the delta as (zero run, literal count, literals) triples. A literal
+ * run only ends at two zero bytes in a row, a single zero is cheaper to keep inline.
+ * @return payload size
+ */
+static size_t encode_delta() {
+  uint8_t* out = payload;
+  size_t i = 0;
+  while (i < FRAME_RECORD_SIZE) {
+    size_t zeros_start = i;
+    // Deltas are mostly zero, skip them a word at a time
+    while (i + 8 <= FRAME_RECORD_SIZE) {
+      uint64_t word;
+      memcpy(&word, &delta[i], sizeof(word));
+      if (word != 0) {
+        break;
+      }
+      i += 8;
+    }
+    while (i < FRAME_RECORD_SIZE && delta[i] == 0) {
+      i++;
+    }
+
+    size_t literal_start = i;
+    while (i < FRAME_RECORD_SIZE &&
+           (delta[i] != 0 || (i + 1 < FRAME_RECORD_SIZE && delta[i + 1] != 0))) {
+      i++;
+    }
+
+    out = put_varint(out, literal_start - zeros_start);
+    out = put_varint(out, i - literal_start);
+    memcpy(out, &delta[literal_start], i - literal_start);
+    out += i - literal_start;
+  }
+  return out - payload;
+}
+
+bool frame_recorder_open(const char* path, uint32_t interval) {
+  if (file) {
+    frame_recorder_close();
+  }
+
+  file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  keyframe_interval = interval > 0 ? interval : 1;
+  offset = 0;
+  write_failed = false;
+  record_offsets.clear();
+
+  write_bytes(FRAME_RECORD_MAGIC, sizeof(FRAME_RECORD_MAGIC));
+  write_le<uint16_t>(LCD_WIDTH);
+  write_le<uint16_t>(LCD_HEIGHT);
+  write_le<uint32_t>(keyframe_interval);
+  return true;
+}
+
+void frame_recorder_add(const uint8_t* frame) {
+  if (!file) {
+    return;
+  }
+
+  // Keyframes are deltas against a white screen, which is mostly what the game shows
+  bool keyframe = record_offsets.size() % keyframe_interval == 0;
+  if (keyframe) {
+    memset(previous, 0xff, sizeof(previous));
+  }
+
+  for (int i = 0; i < FRAME_RECORD_SIZE; i++) {
+    delta[i] = frame[i] ^ previous[i];
+  }
+  memcpy(previous, frame, sizeof(previous));
+
+  size_t size = encode_delta();
+  record_offsets.push_back(offset);
+  write_le<uint8_t>(keyframe ? FRAME_RECORD_KEY : FRAME_RECORD_DELTA);
+  write_le<uint32_t>((uint32_t)size);
+  write_bytes(payload, size);
+}
+
+bool frame_recorder_close() {
+  if (!file) {
+    return false;
+  }
+
+  uint64_t index_offset = offset;
+  for (uint64_t record_offset : record_offsets) {
+    write_le<uint64_t>(record_offset);
+  }
+  write_le<uint32_t>((uint32_t)record_offsets.size());
+  write_le<uint64_t>(index_offset);
+  write_bytes(FRAME_RECORD_INDEX_MAGIC, sizeof(FRAME_RECORD_INDEX_MAGIC));
+
+  bool ok = !write_failed && fclose(file) == 0;
+  file = nullptr;
+  return ok;
+}
+
+bool frame_recorder_is_open() {
+  return file != nullptr;
+}
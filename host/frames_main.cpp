@@ -0,0 +1,98 @@
+// Inspects a frame recording made with --record: prints its size and decode times, and
+// extracts single frames as PBM images.
+//
+//   orbitris_frames FILE [--frame N --pbm OUT]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "frame_record.h"
+
+static bool write_pbm(const char* path, const uint8_t* frame) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  // PBM rows are packed the same way, but 1 is black there
+  fprintf(file, "P4\n%d %d\n", LCD_WIDTH, LCD_HEIGHT);
+  for (int i = 0; i < FRAME_RECORD_SIZE; i++) {
+    fputc((uint8_t)~frame[i], file);
+  }
+  return fclose(file) == 0;
+}
+
+int main(int argc, char const *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s FILE [--frame N --pbm OUT]\n", argv[0]);
+    return 2;
+  }
+
+  uint32_t frame_number = 0;
+  const char* pbm_path = nullptr;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--frame") == 0 && i + 1 < argc) {
+      frame_number = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--pbm") == 0 && i + 1 < argc) {
+      pbm_path = argv[++i];
+    }
+  }
+
+  static FrameReader reader;
+  if (!frame_reader_open(reader, argv[1])) {
+    fprintf(stderr, "%s is not a complete frame recording\n", argv[1]);
+    return 1;
+  }
+
+  if (reader.frame_count == 0) {
+    fprintf(stderr, "no frames\n");
+    frame_reader_close(reader);
+    return 0;
+  }
+
+  uint64_t payload_bytes = 0;
+  for (uint32_t i = 0; i < reader.frame_count; i++) {
+    payload_bytes += frame_reader_record_size(reader, i);
+  }
+
+  auto ts = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < reader.frame_count; i++) {
+    if (!frame_reader_get(reader, i)) {
+      fprintf(stderr, "frame %u is corrupt\n", i);
+      frame_reader_close(reader);
+      return 1;
+    }
+  }
+  auto sequential_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ts).count();
+
+  // Worst case seek: the frame right before a keyframe, decoded from scratch
+  reader.frame_number = -1;
+  uint32_t worst = reader.frame_count - 1;
+  if (reader.frame_count > reader.keyframe_interval) {
+    worst = reader.keyframe_interval - 1;
+  }
+  ts = std::chrono::steady_clock::now();
+  frame_reader_get(reader, worst);
+  auto seek_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ts).count();
+
+  fprintf(stderr, "%u frames, keyframe every %u, %zu bytes, %llu B/frame payload (%.1fx), "
+          "%.1f us/frame sequential, %lld us worst seek\n",
+          reader.frame_count, reader.keyframe_interval, reader.size,
+          (unsigned long long)(payload_bytes / reader.frame_count),
+          (double)reader.frame_count * FRAME_RECORD_SIZE / (payload_bytes ? payload_bytes : 1),
+          (double)sequential_us / reader.frame_count, (long long)seek_us);
+
+  int result = 0;
+  if (pbm_path) {
+    const uint8_t* frame = frame_reader_get(reader, frame_number);
+    if (!frame || !write_pbm(pbm_path, frame)) {
+      fprintf(stderr, "can't extract frame %u to %s\n", frame_number, pbm_path);
+      result = 1;
+    }
+  }
+
+  frame_reader_close(reader);
+  return result;
+}
@@ -0,0 +1,40 @@
+// Host stand-in for the subset of the Arduino core used by the device sources: timing,
+// digital pins and Serial. Implemented in host/arduino_host.cpp.
+
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+unsigned long millis();
+
+unsigned long micros();
+
+void delay(uint32_t ms);
+
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+
+int digitalRead(uint8_t pin);
+
+void digitalWrite(uint8_t pin, uint8_t val);
+
+class HardwareSerial {
+ public:
+  void begin(unsigned long baud);
+  size_t print(const char* str);
+  size_t println(const char* str);
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,29 @@
+// Host stand-in for the Arduino SPI class. The bytes go to the same hook as the ESP-IDF
+// SPI stand-in, and the call blocks for their time on the bus, like the polling
+// transfers of the Arduino core.
+
+#pragma once
+
+#include <cstdint>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0x00
+
+class SPISettings {
+ public:
+  SPISettings(uint32_t clock = 1000000, uint8_t bit_order = MSBFIRST, uint8_t data_mode = SPI_MODE0) : clock(clock) {}
+  uint32_t clock;
+};
+
+class SPIClass {
+ public:
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+  void beginTransaction(SPISettings settings);
+  void endTransaction();
+  void transferBytes(const uint8_t* data, uint8_t* out, uint32_t size);
+
+ private:
+  uint32_t clock = 1000000;
+};
+
+extern SPIClass SPI;
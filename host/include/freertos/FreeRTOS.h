@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
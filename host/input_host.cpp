@@ -0,0 +1,66 @@
+#include "../orbitris_esp32/input.h"
+
+#include <iterator>
+
+// Scripted input for headless runs: leaves the menu for a new game, drops three pieces onto
+// the board so that the last one clears a line, pauses and resumes, ends the game, starts
+// another one, goes back to the menu from the pause screen and moves the focus around
+// there. Each key is held for its number of frames and released after that.
+struct ScriptedPress {
+  int frame;
+  int key;
+  int frames = 1;
+};
+
+constexpr ScriptedPress SCRIPT[] = {
+  { 30, ESP_KEY_A },  // menu: new game
+  { 95, ESP_KEY_RIGHT },  // game: slow the orbit down until the piece falls in and lands
+  { 100, ESP_KEY_DOWN, 118 },
+  { 285, ESP_KEY_LEFT },
+  { 290, ESP_KEY_DOWN, 113 },
+  { 496, ESP_KEY_LEFT },
+  { 501, ESP_KEY_DOWN, 102 },  // this piece clears a line
+  { 900, ESP_KEY_A },  // game: pause
+  { 1000, ESP_KEY_A },  // pause: continue
+  { 1300, ESP_KEY_B },  // game: game over
+  { 1800, ESP_KEY_A },  // game over: new game
+  { 2000, ESP_KEY_A },  // game: pause
+  { 2010, ESP_KEY_RIGHT },
+  { 2020, ESP_KEY_A },  // pause: main menu
+  { 2100, ESP_KEY_DOWN },  // menu: move the focus, twice while it is still moving
+  { 2115, ESP_KEY_DOWN },
+  { 2160, ESP_KEY_UP },
+  { 2200, ESP_KEY_A },  // press and release on a button that does nothing
+};
+
+static int frame = 0;
+
+void input_init() {
+  frame = 0;
+}
+
+void input_update() {
+  frame++;
+}
+
+static bool is_scripted(int key, int down_frame) {
+  for (size_t i = 0; i < std::size(SCRIPT); i++) {
+    if (SCRIPT[i].key == key && down_frame >= SCRIPT[i].frame &&
+        down_frame < SCRIPT[i].frame + SCRIPT[i].frames) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool is_key_down(int key) {
+  return is_scripted(key, frame);
+}
+
+bool is_key_pressed(int key) {
+  return is_scripted(key, frame) && !is_scripted(key, frame - 1);
+}
+
+bool is_key_released(int key) {
+  return !is_scripted(key, frame) && is_scripted(key, frame - 1);
+}
@@ -0,0 +1,374 @@
+// Headless frame loop running the game against the device LCD driver, with the SPI
+// transfers simulated by esp_idf_host.cpp. Reports frame times with the DMA transfer
+// overlapping the next frame (default) or waited for right away (--blocking), and
+// how far the panel falls behind with an SPI budget per frame (--budget-us).
+//
+// The bytes on the bus are decoded by the panel emulator in sharp_emulator.cpp:
+// --check compares the rebuilt panel with the framebuffer after every fully sent frame,
+// --dump saves the final panel image, --spi-clock changes the simulated bus clock.
+// --record FILE captures every frame handed to lcd_update() (see frame_record.h).
+// --bench-draw N times the draw primitives over N runs of a test scene in each scale and
+// mask state, with the per-pixel loops specialized and checking the state per pixel.
+// Frames are recorded into the display list and replayed from it; the report splits the
+// time between the two. --immediate draws them straight from the screens instead, and
+// --threads N replays them in N horizontal bands in parallel (see band_raster.h).
+//
+// Built with LCD_STRIP_LINES > 0, frames go through lcd_update_strips() instead. There
+// is no framebuffer to check against then, and recordings are taken from the emulated
+// panel once each frame is sent.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../orbitris_esp32/display_list.h"
+#include "../orbitris_esp32/draw.h"
+#include "../orbitris_esp32/game_main.h"
+#include "../orbitris_esp32/input.h"
+#include "../orbitris_esp32/screen.h"
+#include "../orbitris_esp32/sharp_display.h"
+#include "band_raster.h"
+#include "esp_idf_host.h"
+#include "frame_record.h"
+#include "sharp_emulator.h"
+
+constexpr int DEFAULT_FRAMES = 600;
+constexpr uint32_t DEFAULT_SPI_CLOCK_HZ = 10000000;  // SPI_CLOCK_HZ in sharp_display.cpp
+constexpr int LCD_CS_GPIO = 21;                      // PIN_NUM_CS in sharp_display.cpp
+
+static void on_gpio_level(int gpio_num, uint32_t level) {
+  if (gpio_num == LCD_CS_GPIO) {
+    sharp_emu_set_cs(level);
+  }
+}
+
+/**
+ * @brief Appends the framebuffer to the recording, if one is open.
+ */
+static void record_frame() {
+  static uint8_t frame[FRAME_RECORD_SIZE];
+  if (frame_recorder_is_open()) {
+#if LCD_STRIP_LINES > 0
+    lcd_wait_update();
+#endif
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+#if LCD_STRIP_LINES > 0
+      memcpy(&frame[y * FRAME_RECORD_BYTES_PER_LINE], sharp_emu_get_line(y), FRAME_RECORD_BYTES_PER_LINE);
+#else
+      lcd_read_line(y, &frame[y * FRAME_RECORD_BYTES_PER_LINE]);
+#endif
+    }
+    frame_recorder_add(frame);
+  }
+}
+
+#if LCD_STRIP_LINES == 0
+/**
+ * @brief Compares the emulated panel with the driver framebuffer, moved by the viewport.
+ * Panel lines the viewport leaves uncovered keep older content and are not compared.
+ * @return number of lines that differ
+ */
+static int check_panel() {
+  int dy, dx;
+  lcd_get_viewport(&dy, &dx);
+
+  int mismatches = 0;
+  for (int panel_y = 0; panel_y < LCD_HEIGHT; panel_y++) {
+    int y = panel_y - dy;
+    if (y < 0 || y >= LCD_HEIGHT) {
+      continue;
+    }
+
+    uint8_t line[SHARP_EMU_BYTES_PER_LINE];
+    uint8_t expected[SHARP_EMU_BYTES_PER_LINE];
+    lcd_read_line(y, line);
+    for (int x = 0; x < SHARP_EMU_BYTES_PER_LINE; x++) {
+      int source_x = x - dx;
+      expected[x] = source_x >= 0 && source_x < SHARP_EMU_BYTES_PER_LINE ? line[source_x] : 0xff;
+    }
+
+    if (memcmp(expected, sharp_emu_get_line(panel_y), sizeof(expected)) != 0) {
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+/**
+ * @brief Draws every primitive with per-pixel loops a few times over the whole screen.
+ */
+static void draw_benchmark_scene() {
+  for (int i = 0; i < 40; i++) {
+    draw_line(i * 10, 0, LCD_WIDTH - 1 - i * 10, LCD_HEIGHT - 1, i & 1);
+  }
+  int pattern_state = 0;
+  for (int i = 0; i < 40; i++) {
+    pattern_state = draw_line_pattern(0, i * 6, LCD_WIDTH - 1, LCD_HEIGHT - 1 - i * 6, pattern_state, 6, 0xe0);
+  }
+  for (int i = 0; i < 20; i++) {
+    draw_rectangle_lines(10 + i * 5, 10 + i * 3, 200, 100, i & 1);
+    draw_rectangle_lines_pattern(Rectangle{ 20.0f + i, 20.0f + i, 360.0f - 2 * i, 200.0f - 2 * i }, 8, 0xcc);
+  }
+  for (int y = 0; y < LCD_HEIGHT; y += 3) {
+    for (int x = 0; x < LCD_WIDTH; x += 3) {
+      draw_pixel(x, y, (x ^ y) & 1);
+    }
+  }
+  print_text(10, 100, 2, "ORBITRIS 0123456789", 0);
+  print_text(10, 140, 1, "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG", 1);
+}
+
+/**
+ * @brief Times draw_benchmark_scene() with and without specialized draw paths.
+ * @return 1 if the two paths drew different pixels
+ */
+static int run_draw_benchmark(int iterations) {
+  struct BenchState {
+    const char* name;
+    float scale;
+    bool mask;
+  };
+  const BenchState states[] = {
+    { "unscaled", 1.0f, false }, { "unscaled+mask", 1.0f, true },
+    { "x2", 2.0f, false },       { "x2+mask", 2.0f, true },
+    { "x0.75", 0.75f, false },   { "x0.75+mask", 0.75f, true },
+  };
+  const DrawMask mask = { 0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55 };
+
+  static uint8_t frames[2][LCD_HEIGHT][SHARP_EMU_BYTES_PER_LINE];
+  int result = 0;
+  for (const BenchState& state : states) {
+    uint64_t path_us[2];
+    for (int specialized = 0; specialized < 2; specialized++) {
+      set_specialized_draw_paths(specialized);
+      push_transform();
+      scale_transform(to_fixed(state.scale));
+      if (state.mask) {
+        begin_mask(mask);
+      }
+
+      auto ts = std::chrono::steady_clock::now();
+      for (int i = 0; i < iterations; i++) {
+        lcd_fill_buffer(1);
+        draw_benchmark_scene();
+      }
+      path_us[specialized] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ts).count();
+
+      end_mask();
+      pop_transform();
+      for (int y = 0; y < LCD_HEIGHT; y++) {
+        lcd_read_line(y, frames[specialized][y]);
+      }
+    }
+
+    bool same = memcmp(frames[0], frames[1], sizeof(frames[0])) == 0;
+    fprintf(stderr, "%-14s per-pixel state %6llu us, specialized %6llu us, %.2fx%s\n", state.name,
+            (unsigned long long)(path_us[0] / iterations), (unsigned long long)(path_us[1] / iterations),
+            path_us[1] ? (double)path_us[0] / path_us[1] : 0.0, same ? "" : ", PIXELS DIFFER");
+    result |= same ? 0 : 1;
+  }
+  set_specialized_draw_paths(true);
+  return result;
+}
+#endif
+
+int main(int argc, char const *argv[]) {
+  int frames = DEFAULT_FRAMES;
+  bool blocking = false;
+  uint32_t budget_us = 0;
+  uint32_t spi_clock_hz = DEFAULT_SPI_CLOCK_HZ;
+  bool check = false;
+  const char* dump_path = nullptr;
+  const char* record_path = nullptr;
+  int bench_draw_iterations = 0;
+  bool immediate = false;
+  int threads = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--blocking") == 0) {
+      blocking = true;
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--budget-us") == 0 && i + 1 < argc) {
+      budget_us = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--spi-clock") == 0 && i + 1 < argc) {
+      spi_clock_hz = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--check") == 0) {
+      check = true;
+    } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      dump_path = argv[++i];
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (strcmp(argv[i], "--bench-draw") == 0 && i + 1 < argc) {
+      bench_draw_iterations = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--immediate") == 0) {
+      immediate = true;
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    }
+  }
+
+#if LCD_STRIP_LINES > 0
+  if (check || bench_draw_iterations > 0 || threads > 1) {
+    fprintf(stderr, "--check, --bench-draw and --threads need the full framebuffer, build with LCD_STRIP_LINES=0\n");
+    return 2;
+  }
+#else
+  if (bench_draw_iterations > 0) {
+    return run_draw_benchmark(bench_draw_iterations);
+  }
+#endif
+
+  if (record_path && !frame_recorder_open(record_path)) {
+    fprintf(stderr, "can't write %s\n", record_path);
+    return 1;
+  }
+
+  sharp_emu_init(spi_clock_hz);
+  esp_host_set_spi_clock(spi_clock_hz);
+  esp_host_on_gpio_level(on_gpio_level);
+  esp_host_on_spi_bytes(sharp_emu_receive);
+
+  lcd_init();
+  lcd_set_time_budget(budget_us);
+  input_init();
+
+  lcd_clear();
+#if LCD_STRIP_LINES > 0
+  set_redraw_underlays(true);
+#else
+  lcd_fill_buffer(1);
+  lcd_update();
+#endif
+
+  init_game();
+  set_display_list_enabled(!immediate);
+  bool parallel = threads > 1 && !immediate;
+  if (parallel) {
+    band_raster_init(threads);
+  }
+
+  uint64_t total_us = 0;
+  uint64_t max_us = 0;
+  uint64_t bytes_sent = 0;
+  uint64_t deferred_lines = 0;
+  int max_deferred_age = 0;
+  int checked_frames = 0;
+  int bad_frames = 0;
+  uint64_t record_us = 0;
+  uint64_t replay_us = 0;
+  uint64_t list_commands = 0;
+  uint64_t list_merged = 0;
+  uint64_t list_culled = 0;
+  int max_list_commands = 0;
+  int overflowed_frames = 0;
+  uint64_t damaged_lines = 0;
+  for (int frame = 0; frame < frames; frame++) {
+    auto ts = std::chrono::steady_clock::now();
+    input_update();
+    update_frame();
+    int damage_first = 0;
+    int damage_count = 0;
+    get_frame_damage_lines(&damage_first, &damage_count);
+    damaged_lines += damage_count;
+    auto record_ts = std::chrono::steady_clock::now();
+    record_draw_frame();
+    auto replay_ts = std::chrono::steady_clock::now();
+#if LCD_STRIP_LINES > 0
+    lcd_update_strips(draw_frame);
+    auto drawn_ts = std::chrono::steady_clock::now();
+    record_frame();
+#else
+    if (parallel) {
+      band_raster_draw();
+    } else {
+      draw_frame();
+    }
+    auto drawn_ts = std::chrono::steady_clock::now();
+    record_frame();
+    lcd_update();
+#endif
+    // In strip mode this includes sending all strips but the last
+    record_us += std::chrono::duration_cast<std::chrono::microseconds>(replay_ts - record_ts).count();
+    replay_us += std::chrono::duration_cast<std::chrono::microseconds>(drawn_ts - replay_ts).count();
+
+    const DisplayListStats& list = display_list_get_stats();
+    list_commands += list.commands;
+    list_merged += list.merged;
+    list_culled += list.culled;
+    max_list_commands = list.commands > max_list_commands ? list.commands : max_list_commands;
+    overflowed_frames += list.overflowed;
+
+    if (blocking) {
+      lcd_wait_update();
+    }
+    auto dt = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ts).count();
+
+    total_us += dt;
+    max_us = dt > max_us ? dt : max_us;
+    const LcdStats& stats = lcd_get_stats();
+    bytes_sent += stats.bytes_sent;
+    deferred_lines += stats.deferred_lines;
+    max_deferred_age = stats.max_deferred_age > max_deferred_age ? stats.max_deferred_age : max_deferred_age;
+
+    // Lines held back by the budget are expected to differ until they go out
+#if LCD_STRIP_LINES == 0
+    if (check && stats.deferred_lines == 0) {
+      lcd_wait_update();
+      checked_frames++;
+      int mismatches = check_panel();
+      if (mismatches > 0) {
+        if (bad_frames == 0) {
+          fprintf(stderr, "frame %d: %d lines differ from the framebuffer\n", frame, mismatches);
+        }
+        bad_frames++;
+      }
+    }
+#endif
+  }
+  lcd_deinit();
+  if (parallel) {
+    band_raster_shutdown();
+  }
+
+  if (frames > 0) {
+    fprintf(stderr, "%s: %d frames, avg %llu us, max %llu us, %llu B/frame, %llu deferred lines/frame, max age %d, %u skipped\n",
+            blocking ? "blocking" : "pipelined", frames,
+            (unsigned long long)(total_us / frames), (unsigned long long)max_us,
+            (unsigned long long)(bytes_sent / frames), (unsigned long long)(deferred_lines / frames),
+            max_deferred_age, (unsigned)lcd_get_stats().skipped_frames);
+
+    const SharpEmuStats& emu = sharp_emu_get_stats();
+    fprintf(stderr, "panel: %u commands, %u lines, %u VCOM toggles, %u protocol errors, %llu us bus time/frame at %u Hz\n",
+            (unsigned)emu.commands, (unsigned)emu.lines_written, (unsigned)emu.vcom_toggles,
+            (unsigned)emu.protocol_errors, (unsigned long long)(emu.bus_time_ns / 1000 / frames),
+            (unsigned)spi_clock_hz);
+    fprintf(stderr, "damage: %llu of %d lines/frame redrawn\n", (unsigned long long)(damaged_lines / frames), LCD_HEIGHT);
+
+    if (immediate) {
+      fprintf(stderr, "immediate: %llu us drawing/frame\n", (unsigned long long)(replay_us / frames));
+    } else {
+      fprintf(stderr, "display list: record %llu us, replay %llu us/frame on %d threads, %llu commands, %llu merged, %llu culled/frame, max %d of %d, %d frames overflowed\n",
+              (unsigned long long)(record_us / frames), (unsigned long long)(replay_us / frames), parallel ? threads : 1,
+              (unsigned long long)(list_commands / frames), (unsigned long long)(list_merged / frames),
+              (unsigned long long)(list_culled / frames), max_list_commands, DISPLAY_LIST_SIZE,
+              overflowed_frames);
+    }
+  }
+
+  if (check) {
+    fprintf(stderr, "check: %d of %d frames differ\n", bad_frames, checked_frames);
+  }
+
+  if (record_path && !frame_recorder_close()) {
+    fprintf(stderr, "can't write %s\n", record_path);
+    return 1;
+  }
+
+  if (dump_path && !sharp_emu_write_pbm(dump_path)) {
+    fprintf(stderr, "can't write %s\n", dump_path);
+    return 1;
+  }
+
+  return (check && bad_frames > 0) || sharp_emu_get_stats().protocol_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+#include "sharp_emulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Mode byte: M0 (update), M1 (VCOM), M2 (all clear), then 5 dummy bits
+#define MODE_UPDATE 0x80
+#define MODE_VCOM 0x40
+#define MODE_ALL_CLEAR 0x20
+
+enum class EmuState {
+  IDLE,     // CS low, nothing expected
+  COMMAND,  // mode byte
+  ADDRESS,  // gate line address, or the final dummy byte of an update
+  DATA,
+  LINE_TRAILER,
+  TRAILER,  // dummy byte of display mode and all clear
+  DONE      // command complete, waiting for CS to fall
+};
+
+static uint8_t panel[LCD_HEIGHT][SHARP_EMU_BYTES_PER_LINE];
+static SharpEmuStats stats{};
+static uint32_t clock_hz = 0;
+
+static EmuState state = EmuState::IDLE;
+static int vcom = -1;
+static int line = 0;
+static int data_index = 0;
+static uint32_t command_bytes = 0;
+
+static uint8_t reverse_bits(uint8_t value) {
+  uint8_t result = 0;
+  for (int i = 0; i < 8; i++) {
+    if (value & (1 << i)) {
+      result |= 0x80 >> i;
+    }
+  }
+  return result;
+}
+
+void sharp_emu_init(uint32_t clock) {
+  memset(panel, 0xff, sizeof(panel));
+  stats = {};
+  clock_hz = clock;
+  state = EmuState::IDLE;
+  vcom = -1;
+}
+
+void sharp_emu_set_cs(int level) {
+  if (level) {
+    if (state == EmuState::IDLE) {
+      state = EmuState::COMMAND;
+      command_bytes = 0;
+    }
+    return;
+  }
+
+  if (state == EmuState::IDLE) {
+    return;
+  }
+
+  // Anything but a completed command is cut short
+  if (state != EmuState::DONE && state != EmuState::COMMAND) {
+    stats.protocol_errors++;
+  }
+
+  if (command_bytes > 0) {
+    stats.commands++;
+    stats.last_command_bytes = command_bytes;
+    stats.last_command_bus_time_us = clock_hz ? (uint64_t)command_bytes * 8 * 1000000 / clock_hz : 0;
+  }
+  state = EmuState::IDLE;
+}
+
+static void receive_byte(uint8_t value) {
+  switch (state) {
+    case EmuState::IDLE:
+      // Clocked out with CS low, the panel ignores it
+      break;
+    case EmuState::COMMAND: {
+      int new_vcom = (value & MODE_VCOM) ? 1 : 0;
+      if (vcom >= 0 && new_vcom != vcom) {
+        stats.vcom_toggles++;
+      }
+      vcom = new_vcom;
+
+      if (value & MODE_UPDATE) {
+        state = EmuState::ADDRESS;
+      } else {
+        if (value & MODE_ALL_CLEAR) {
+          memset(panel, 0xff, sizeof(panel));
+        }
+        state = EmuState::TRAILER;
+      }
+      break;
+    }
+    case EmuState::ADDRESS: {
+      // Addresses go out least significant bit first, and there is no line 0, so a
+      // zero byte is the dummy closing the update
+      int address = reverse_bits(value);
+      if (address == 0) {
+        state = EmuState::DONE;
+      } else if (address > LCD_HEIGHT) {
+        stats.protocol_errors++;
+        state = EmuState::DONE;
+      } else {
+        line = address - 1;
+        data_index = 0;
+        state = EmuState::DATA;
+      }
+      break;
+    }
+    case EmuState::DATA:
+      panel[line][data_index++] = value;
+      if (data_index == SHARP_EMU_BYTES_PER_LINE) {
+        stats.lines_written++;
+        state = EmuState::LINE_TRAILER;
+      }
+      break;
+    case EmuState::LINE_TRAILER:
+      state = EmuState::ADDRESS;
+      break;
+    case EmuState::TRAILER:
+      state = EmuState::DONE;
+      break;
+    case EmuState::DONE:
+      stats.protocol_errors++;
+      break;
+  }
+}
+
+void sharp_emu_receive(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    receive_byte(data[i]);
+  }
+
+  command_bytes += len;
+  stats.bytes += len;
+  if (clock_hz) {
+    stats.bus_time_ns += (uint64_t)len * 8 * 1000000000ull / clock_hz;
+  }
+}
+
+const uint8_t* sharp_emu_get_line(int y) {
+  return panel[y];
+}
+
+const SharpEmuStats& sharp_emu_get_stats() {
+  return stats;
+}
+
+bool sharp_emu_write_pbm(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  // PBM rows are packed the same way, but 1 is black there
+  fprintf(file, "P4\n%d %d\n", LCD_WIDTH, LCD_HEIGHT);
+  for (int y = 0; y < LCD_HEIGHT; y++) {
+    uint8_t row[SHARP_EMU_BYTES_PER_LINE];
+    for (int x = 0; x < SHARP_EMU_BYTES_PER_LINE; x++) {
+      row[x] = ~panel[y][x];
+    }
+    fwrite(row, 1, sizeof(row), file);
+  }
+
+  fclose(file);
+  return true;
+}
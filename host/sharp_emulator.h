@@ -0,0 +1,52 @@
+// Host emulator of the Sharp LS027B7DH01 memory LCD serial interface. Rebuilds the panel
+// memory from the bytes clocked out while CS is high and accounts for their bus time.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../orbitris_esp32/const.h"
+
+constexpr int SHARP_EMU_BYTES_PER_LINE = LCD_WIDTH / 8;
+
+struct SharpEmuStats {
+  uint32_t commands;         // CS windows seen
+  uint32_t lines_written;
+  uint32_t vcom_toggles;     // commands that flipped VCOM relative to the previous one
+  uint32_t protocol_errors;  // bad addresses, truncated lines, bytes after the trailer
+  uint64_t bytes;
+  uint64_t bus_time_ns;
+  uint32_t last_command_bytes;
+  uint32_t last_command_bus_time_us;
+};
+
+/**
+ * @brief Resets the panel memory to white and clears the counters.
+ * @param clock_hz SPI clock used to account bus time.
+ */
+void sharp_emu_init(uint32_t clock_hz);
+
+/**
+ * @brief Feeds the CS line. A rising edge starts a command, a falling edge ends it.
+ */
+void sharp_emu_set_cs(int level);
+
+/**
+ * @brief Feeds bytes clocked out on MOSI, most significant bit first.
+ */
+void sharp_emu_receive(const uint8_t* data, size_t len);
+
+/**
+ * @brief Returns a line of the panel memory, SHARP_EMU_BYTES_PER_LINE bytes, leftmost
+ * pixel in the most significant bit, 1 for white.
+ */
+const uint8_t* sharp_emu_get_line(int y);
+
+const SharpEmuStats& sharp_emu_get_stats();
+
+/**
+ * @brief Saves the panel memory as a binary PBM image.
+ * @return false if the file can't be written
+ */
+bool sharp_emu_write_pbm(const char* path);
@@ -4,9 +4,10 @@
 #include "draw.h"
 
 Button::Button(Rectangle rect, const char *label, int scale, int id)
-  : rect_{ rect }, label_{ label }, text_scale_{ scale }, id_{ id }, state_{ ButtonState::idle } {}
+  : rect_{ rect }, label_{ label }, text_scale_{ scale }, id_{ id }, state_{ ButtonState::idle }, dirty_{ true } {}
 
 void Button::set_state(ButtonState new_state) {
+  dirty_ |= new_state != state_;
   state_ = new_state;
 }
 
@@ -18,6 +19,13 @@ int Button::get_id() const {
   return id_;
 }
 
+void Button::collect_dirty_rect(Rectangle &dirty) {
+  if (dirty_) {
+    dirty = get_union_rec(dirty, rect_);
+    dirty_ = false;
+  }
+}
+
 void Button::draw() const {
   int x = rect_.x;
   int y = rect_.y;
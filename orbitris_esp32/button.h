@@ -18,6 +18,11 @@ public:
 
   int get_id() const;
 
+  /**
+   * @brief Adds the button's rectangle to dirty if its state changed since the last call.
+   */
+  void collect_dirty_rect(Rectangle& dirty);
+
   void draw() const;
 
 private:
@@ -26,4 +31,5 @@ private:
   int text_scale_;
   int id_;
   ButtonState state_;
+  bool dirty_;
 };
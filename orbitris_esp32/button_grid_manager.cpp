@@ -16,7 +16,8 @@ ButtonGridManager::ButtonGridManager(
     focused_grid_row_(BUTTON_NO_ACTION),
     focused_grid_col_(BUTTON_NO_ACTION),
     anim_timer_(0),
-    action_was_pressed_(false) {
+    action_was_pressed_(false),
+    dirty_rect_{} {
   init_focus();
 }
 
@@ -28,6 +29,7 @@ void ButtonGridManager::init() {
 int ButtonGridManager::update() {
   int prev_r = focused_grid_row_;
   int prev_c = focused_grid_col_;
+  Rectangle prev_frame = get_focus_frame_rect();
 
   int dir_r = 0;
   int dir_c = 0;
@@ -91,6 +93,17 @@ int ButtonGridManager::update() {
   if (anim_timer_ < ANIMATION_FRAMES) {
     anim_timer_++;
   }
+  update_focus_rect();
+
+  dirty_rect_ = {};
+  Rectangle frame = get_focus_frame_rect();
+  if (frame.x != prev_frame.x || frame.y != prev_frame.y || frame.width != prev_frame.width ||
+      frame.height != prev_frame.height) {
+    dirty_rect_ = get_union_rec(prev_frame, frame);
+  }
+  for (size_t i = 0; i < count_; i++) {
+    all_buttons_[i].collect_dirty_rect(dirty_rect_);
+  }
 
   return action_id;
 }
@@ -103,6 +116,29 @@ void ButtonGridManager::draw() const {
   draw_animated_focus_frame();
 }
 
+void ButtonGridManager::draw_dirty(int background) const {
+  if (dirty_rect_.width <= 0 || dirty_rect_.height <= 0) {
+    return;
+  }
+
+  // Everything drawn over the cleared area is redrawn whole: outside of it, the same pixels
+  // land on themselves
+  draw_rectangle(dirty_rect_, background);
+  for (size_t i = 0; i < count_; i++) {
+    if (check_collision_recs(all_buttons_[i].get_rect(), dirty_rect_)) {
+      all_buttons_[i].draw();
+    }
+  }
+
+  if (check_collision_recs(get_focus_frame_rect(), dirty_rect_)) {
+    draw_animated_focus_frame();
+  }
+}
+
+const Rectangle &ButtonGridManager::get_dirty_rect() const {
+  return dirty_rect_;
+}
+
 void ButtonGridManager::init_focus() {
   int prev_r = focused_grid_row_;
   int prev_c = focused_grid_col_;
@@ -148,7 +184,7 @@ void ButtonGridManager::update_focus_state_logic(int old_index, int new_index) {
   anim_timer_ = 0;
 }
 
-void ButtonGridManager::draw_animated_focus_frame() const {
+void ButtonGridManager::update_focus_rect() {
   if (anim_timer_ < ANIMATION_FRAMES) {
     float t_normalized = (float)anim_timer_ / ANIMATION_FRAMES;
     float t_eased = ease_out_quad(t_normalized);
@@ -164,14 +200,19 @@ void ButtonGridManager::draw_animated_focus_frame() const {
     current_focus_rect_.width = anim_target_rect_.width;
     current_focus_rect_.height = anim_target_rect_.height;
   }
+}
 
-  // Draw the frame
+Rectangle ButtonGridManager::get_focus_frame_rect() const {
   int x = current_focus_rect_.x;
   int y = current_focus_rect_.y;
   int w = current_focus_rect_.width;
   int h = current_focus_rect_.height;
+  return { (float)x, (float)y, (float)w, (float)h };
+}
 
-  draw_rectangle_lines(x, y, w, h, LCD_BLACK);
+void ButtonGridManager::draw_animated_focus_frame() const {
+  Rectangle frame = get_focus_frame_rect();
+  draw_rectangle_lines(frame.x, frame.y, frame.width, frame.height, LCD_BLACK);
 }
 
 Rectangle ButtonGridManager::get_animation_rect(int index) const {
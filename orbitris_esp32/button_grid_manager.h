@@ -21,6 +21,19 @@ public:
 
   void draw() const;
 
+  /**
+   * @brief Repaints only what the last update() changed, over a background of the given
+   * color: buttons whose state changed and the focus frame's old and new place while it
+   * moves. Needs the render target to still hold the previous frame. Draws nothing when
+   * the focus is at rest.
+   */
+  void draw_dirty(int background) const;
+
+  /**
+   * @brief Returns the area draw_dirty() repaints, empty if none.
+   */
+  const Rectangle& get_dirty_rect() const;
+
 private:
   Button* all_buttons_;
   size_t count_;
@@ -32,17 +45,27 @@ private:
   int focused_grid_row_;
   int focused_grid_col_;
 
-  mutable Rectangle current_focus_rect_;
+  Rectangle current_focus_rect_;
   Rectangle anim_start_rect_;
   Rectangle anim_target_rect_;
   int anim_timer_;
 
   bool action_was_pressed_;
 
+  // Pixels changed by the last update(), empty if none
+  Rectangle dirty_rect_;
+
   void init_focus();
 
   void update_focus_state_logic(int old_index, int new_index);
 
+  void update_focus_rect();
+
+  /**
+   * @brief Returns the pixels the focus frame covers, its rectangle snapped the way it is drawn.
+   */
+  Rectangle get_focus_frame_rect() const;
+
   void draw_animated_focus_frame() const;
 
   Rectangle get_animation_rect(int index) const;
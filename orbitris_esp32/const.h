@@ -1,5 +1,11 @@
 #pragma once
 
+// Host builds rasterize frames in bands on several threads (see host/band_raster.h), so
+// the drawing state is kept per thread there. The device draws from a single task.
+#ifndef DRAW_THREAD_LOCAL
+#define DRAW_THREAD_LOCAL
+#endif
+
 constexpr auto LCD_WIDTH = 400;
 constexpr auto LCD_HEIGHT = 240;
 constexpr int CENTER_X = LCD_WIDTH / 2;
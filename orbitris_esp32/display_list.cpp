@@ -0,0 +1,186 @@
+#include "display_list.h"
+
+#include <atomic>
+
+#include "const.h"
+
+static DrawCommand commands[DISPLAY_LIST_SIZE];
+static int command_count = 0;
+// Framebuffer commands before this one are covered by an unmasked screen fill, only their
+// state changes matter
+static int first_visible = 0;
+static bool recording = false;
+// Between BEGIN_SURFACE and END_SURFACE while recording
+static bool in_surface = false;
+
+static DisplayListStats stats{};
+// Replays can run on several threads at once, each drawing a band
+static std::atomic<int> culled_commands{ 0 };
+
+extern void lcd_get_raster_lines(int* first, int* count);
+
+static bool is_draw_command(DrawOp op) {
+  return op < DrawOp::BEGIN_MASK;
+}
+
+void display_list_begin() {
+  command_count = 0;
+  first_visible = 0;
+  recording = true;
+  in_surface = false;
+  stats = {};
+  culled_commands = 0;
+}
+
+void display_list_end() {
+  recording = false;
+}
+
+bool display_list_is_recording() {
+  return recording;
+}
+
+/**
+ * @brief Extends the last command if it is a fill of the same color and columns ending
+ * right where this one starts.
+ */
+static bool merge_fill(const DrawCommand& command) {
+  // Scaled, two fills can round differently than the one covering both
+  if (command_count == first_visible || is_scaling()) {
+    return false;
+  }
+
+  DrawCommand& last = commands[command_count - 1];
+  if (last.op != DrawOp::RECT || last.color != command.color || last.x != command.x ||
+      last.w != command.w || last.y + last.h != command.y) {
+    return false;
+  }
+
+  last.h += command.h;
+  last.bottom = command.bottom > last.bottom ? command.bottom : last.bottom;
+  return true;
+}
+
+void display_list_record(const DrawCommand& command) {
+  if (command.op == DrawOp::RECT && merge_fill(command)) {
+    stats.merged++;
+    return;
+  }
+
+  if (command_count == DISPLAY_LIST_SIZE) {
+    stats.overflowed = true;
+    return;
+  }
+
+  if (command.op == DrawOp::BEGIN_SURFACE || command.op == DrawOp::END_SURFACE) {
+    in_surface = command.op == DrawOp::BEGIN_SURFACE;
+  }
+
+  // An unmasked fill covers everything drawn to the framebuffer so far
+  if (command.op == DrawOp::FILL_SCREEN && !command.pattern && !in_surface) {
+    first_visible = command_count;
+  }
+
+  commands[command_count++] = command;
+  stats.commands = command_count;
+}
+
+static void replay_command(const DrawCommand& c) {
+  switch (c.op) {
+    case DrawOp::FILL_SCREEN:
+      fill_scrfeen_buffer(c.color);
+      break;
+    case DrawOp::PIXEL:
+      draw_pixel(c.x, c.y, c.color);
+      break;
+    case DrawOp::RECT:
+      draw_rectangle(Rectangle{ (float)c.x, (float)c.y, (float)c.w, (float)c.h }, c.color);
+      break;
+    case DrawOp::CHECKERBOARD:
+      draw_rectangle_checkerboard(c.x, c.y, c.w, c.h);
+      break;
+    case DrawOp::RECT_LINES:
+      draw_rectangle_lines(c.x, c.y, c.w, c.h, c.color);
+      break;
+    case DrawOp::RECT_LINES_PATTERN:
+      draw_rectangle_lines_pattern(Rectangle{ (float)c.x, (float)c.y, (float)c.w, (float)c.h }, c.pattern_size, c.pattern);
+      break;
+    case DrawOp::LINE:
+      draw_line(c.x, c.y, c.w, c.h, c.color);
+      break;
+    case DrawOp::LINE_PATTERN:
+      draw_line_pattern(c.x, c.y, c.w, c.h, c.value, c.pattern_size, c.pattern);
+      break;
+    case DrawOp::CONIC_ARC:
+      draw_conic_arc(*c.conic);
+      break;
+    case DrawOp::CHAR:
+      draw_char(c.x, c.y, c.color, c.pattern, c.w);
+      break;
+    case DrawOp::SPRITE:
+      draw_sprite(*c.sprite, c.x, c.y, (BlitOp)c.color);
+      break;
+    case DrawOp::SURFACE:
+      draw_surface(Surface{ c.raster, false });
+      break;
+    case DrawOp::BEGIN_MASK:
+      begin_mask(c.mask);
+      break;
+    case DrawOp::END_MASK:
+      end_mask();
+      break;
+    case DrawOp::PUSH_TRANSFORM:
+      push_transform();
+      break;
+    case DrawOp::POP_TRANSFORM:
+      pop_transform();
+      break;
+    case DrawOp::SCALE_TRANSFORM:
+      scale_transform(c.value);
+      break;
+    case DrawOp::TRANSLATE_TRANSFORM:
+      translate_transform(c.x, c.y);
+      break;
+    case DrawOp::BEGIN_SURFACE:
+      begin_surface(Surface{ c.raster, false });
+      break;
+    case DrawOp::END_SURFACE:
+      end_surface();
+      break;
+  }
+}
+
+void display_list_replay() {
+  // Line bounds were taken without any outer transform
+  bool cull = !is_transformed();
+  int first_line = 0;
+  int line_count = LCD_HEIGHT;
+  lcd_get_raster_lines(&first_line, &line_count);
+  int last_line = first_line + line_count - 1;
+
+  int culled = 0;
+  bool drawing_surface = false;
+  for (int i = 0; i < command_count; i++) {
+    const DrawCommand& c = commands[i];
+    if (c.op == DrawOp::BEGIN_SURFACE || c.op == DrawOp::END_SURFACE) {
+      drawing_surface = c.op == DrawOp::BEGIN_SURFACE;
+    }
+
+    if (cull && is_draw_command(c.op) &&
+        ((i < first_visible && !drawing_surface) || c.bottom < first_line || c.top > last_line)) {
+      culled++;
+      continue;
+    }
+    replay_command(c);
+  }
+  culled_commands += culled;
+}
+
+bool display_list_overflowed() {
+  return stats.overflowed;
+}
+
+const DisplayListStats& display_list_get_stats() {
+  stats.culled = culled_commands;
+  return stats;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include "draw.h"
+
+// Commands a frame can record before display_list_overflowed() reports it
+#ifndef DISPLAY_LIST_SIZE
+#define DISPLAY_LIST_SIZE 768
+#endif
+
+enum class DrawOp : uint8_t {
+  FILL_SCREEN,
+  PIXEL,
+  RECT,
+  CHECKERBOARD,
+  RECT_LINES,
+  RECT_LINES_PATTERN,
+  LINE,
+  LINE_PATTERN,
+  CONIC_ARC,
+  CHAR,
+  SPRITE,
+  SURFACE,
+  BEGIN_MASK,
+  END_MASK,
+  PUSH_TRANSFORM,
+  POP_TRANSFORM,
+  SCALE_TRANSFORM,
+  TRANSLATE_TRANSFORM,
+  BEGIN_SURFACE,
+  END_SURFACE,
+};
+
+/**
+ * @brief One recorded draw call with the arguments it was made with, before the transform.
+ * Which fields are used depends on op, see the draw functions in draw.cpp.
+ */
+struct DrawCommand {
+  DrawOp op;
+  uint8_t color;         // color, glyph scale or BlitOp
+  uint8_t pattern;       // line pattern, character code or, for fills, whether masked
+  uint8_t pattern_size;
+  int32_t x, y;          // position or first point
+  int32_t w, h;          // size or second point
+  union {
+    int32_t value;         // pattern state or transform argument
+    const Sprite* sprite;  // must stay valid until the frame is replayed
+    uint32_t* raster;      // of a surface, same
+    const ConicArc* conic; // same
+    DrawMask mask;
+  };
+  int16_t top, bottom;   // screen lines touched under the transform at record time
+};
+
+/**
+ * @brief Counters of the frame recorded last.
+ */
+struct DisplayListStats {
+  uint16_t commands;  // commands recorded
+  uint16_t merged;    // fills folded into the previous command while recording
+  uint16_t culled;    // draw commands skipped by replays, hidden or outside the lines drawn
+  bool overflowed;    // the frame didn't fit in DISPLAY_LIST_SIZE commands
+};
+
+/**
+ * @brief Starts recording: until display_list_end(), the draw functions in draw.h append
+ * commands instead of drawing. Transforms and masks still take effect, so draw calls
+ * return what they would when drawing.
+ */
+void display_list_begin();
+
+void display_list_end();
+
+bool display_list_is_recording();
+
+/**
+ * @brief Appends a command, folding rectangle fills into the previous one when they
+ * continue it. Called by draw.cpp.
+ */
+void display_list_record(const DrawCommand& command);
+
+/**
+ * @brief Draws the recorded frame. Can be called any number of times, also from several
+ * threads at once as long as each draws its own lines (see lcd_set_clip_lines()).
+ *
+ * Commands drawing only outside the framebuffer lines currently rendered (see
+ * lcd_get_raster_lines()) are skipped, as is everything covered by a later unmasked
+ * fill_scrfeen_buffer() outside of surfaces. When called under a transform, the whole frame is drawn through it
+ * without skipping anything.
+ */
+void display_list_replay();
+
+/**
+ * @brief True if the last frame didn't fit; it has to be drawn directly then.
+ */
+bool display_list_overflowed();
+
+const DisplayListStats& display_list_get_stats();
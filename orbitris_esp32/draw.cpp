@@ -5,23 +5,48 @@
 #include <cstdlib>
 #include <cstdint>
 #include <cstring>
+#include <new>
 
 #include "charmap.h"
 #include "const.h"
+#include "display_list.h"
 
 constexpr int FONT_MAP_SIZE = FONT_END_CHAR - FONT_START_CHAR + 1;
 
-constexpr float SCALE_EPSILON = 0.01f;
+// Scales closer to 1 than this are not applied, Q16.16
+constexpr int32_t SCALE_EPSILON = FIXED_ONE / 100;
 
-// Scaling
-static bool g_should_scale = false;
-static float g_draw_scale = 1.0f;
-static float g_screen_scale = 1.0f;
-static float g_scale = 1.0f;
+/**
+ * @brief Draw transform, all in Q16.16: a point p is drawn at (p * scale + x) >> 16.
+ */
+struct DrawTransform {
+  int32_t scale;
+  int32_t x;
+  int32_t y;
+};
+
+enum class TransformMode {
+  IDENTITY,
+  INTEGER,  // whole scale and offsets, points are mapped with g_int_scale, g_int_x, g_int_y
+  FIXED,
+};
+
+static DRAW_THREAD_LOCAL DrawTransform g_transform = { FIXED_ONE, 0, 0 };
+static DRAW_THREAD_LOCAL DrawTransform g_transform_stack[DRAW_TRANSFORM_DEPTH];
+static DRAW_THREAD_LOCAL int g_transform_depth = 0;
+
+// Coefficients of g_transform for the specialized paths, updated when it changes
+static DRAW_THREAD_LOCAL TransformMode g_transform_mode = TransformMode::IDENTITY;
+static DRAW_THREAD_LOCAL int g_int_scale = 1;
+static DRAW_THREAD_LOCAL int g_int_x = 0;
+static DRAW_THREAD_LOCAL int g_int_y = 0;
+
+// Per-pixel loops specialized for the draw state, see with_draw_state()
+static bool g_specialized_paths = true;
 
 // Draw masking
-static bool g_should_mask = false;
-static DrawMask g_draw_mask = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+static DRAW_THREAD_LOCAL bool g_should_mask = false;
+static DRAW_THREAD_LOCAL DrawMask g_draw_mask = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
 
 extern void lcd_draw_pixel(int x, int y, int color);
 
@@ -29,44 +54,232 @@ extern void lcd_fill_buffer(int color);
 
 extern void lcd_fill_line(int line, uint8_t pattern, int color);
 
-static void update_scale() {
-  g_scale = g_draw_scale * g_screen_scale;
-  if (fabsf(g_scale - 1.0f) > SCALE_EPSILON) {
-    g_should_scale = true;
+extern void lcd_fill_span_pattern(int y, int x0, int x1, uint8_t pattern, int color);
+
+extern void lcd_set_viewport(int dy, int dx_bytes);
+
+extern void lcd_write_bits(int y, int x, uint32_t set, uint32_t clear, uint32_t toggle);
+
+extern int lcd_raster_words();
+
+extern void lcd_set_target(uint32_t* raster);
+
+extern void lcd_copy_raster(const uint32_t* source, const uint8_t* mask);
+
+extern void lcd_copy_raster_scaled(const uint32_t* source, const int16_t* source_rows, const int16_t* source_columns,
+                                   const uint8_t* mask);
+
+static void update_transform() {
+  constexpr int32_t FRACTION = FIXED_ONE - 1;
+  if (g_transform.scale == FIXED_ONE && g_transform.x == 0 && g_transform.y == 0) {
+    g_transform_mode = TransformMode::IDENTITY;
+  } else if (((g_transform.scale | g_transform.x | g_transform.y) & FRACTION) == 0) {
+    g_transform_mode = TransformMode::INTEGER;
+    g_int_scale = g_transform.scale >> FIXED_SHIFT;
+    g_int_x = g_transform.x >> FIXED_SHIFT;
+    g_int_y = g_transform.y >> FIXED_SHIFT;
   } else {
-    g_should_scale = false;
+    g_transform_mode = TransformMode::FIXED;
   }
 }
 
-void begin_scale(float scale) {
-  g_draw_scale = scale;
-  update_scale();
+static DrawCommand make_command(DrawOp op, int x = 0, int y = 0, int w = 0, int h = 0, int color = 0) {
+  DrawCommand command{};
+  command.op = op;
+  command.x = x;
+  command.y = y;
+  command.w = w;
+  command.h = h;
+  command.color = color;
+  return command;
+}
+
+/**
+ * @brief Appends a draw command to the display list, with the screen lines between a and
+ * b (either order) it touches under the current transform.
+ */
+static void record_command(DrawCommand command, int a, int b) {
+  command.top = std::clamp(std::min(a, b), INT16_MIN, INT16_MAX);
+  command.bottom = std::clamp(std::max(a, b), INT16_MIN, INT16_MAX);
+  display_list_record(command);
+}
+
+void push_transform() {
+  if (display_list_is_recording()) {
+    display_list_record(make_command(DrawOp::PUSH_TRANSFORM));
+  }
+
+  if (g_transform_depth < DRAW_TRANSFORM_DEPTH) {
+    g_transform_stack[g_transform_depth] = g_transform;
+  }
+  g_transform_depth++;
+}
+
+void pop_transform() {
+  if (g_transform_depth == 0) {
+    return;
+  }
+
+  if (display_list_is_recording()) {
+    display_list_record(make_command(DrawOp::POP_TRANSFORM));
+  }
+
+  g_transform_depth--;
+  if (g_transform_depth < DRAW_TRANSFORM_DEPTH) {
+    g_transform = g_transform_stack[g_transform_depth];
+  }
+  update_transform();
+}
+
+void scale_transform(int32_t scale) {
+  if (abs(scale - FIXED_ONE) <= SCALE_EPSILON) {
+    return;
+  }
+
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::SCALE_TRANSFORM);
+    command.value = scale;
+    display_list_record(command);
+  }
+
+  // p -> (p - center) * scale + center, then the current transform
+  int64_t current = g_transform.scale;
+  g_transform.x += ((int64_t)CENTER_X * (FIXED_ONE - scale) * current) >> FIXED_SHIFT;
+  g_transform.y += ((int64_t)CENTER_Y * (FIXED_ONE - scale) * current) >> FIXED_SHIFT;
+  g_transform.scale = ((int64_t)scale * current) >> FIXED_SHIFT;
+  update_transform();
+}
+
+void translate_transform(int dx, int dy) {
+  if (display_list_is_recording()) {
+    display_list_record(make_command(DrawOp::TRANSLATE_TRANSFORM, dx, dy));
+  }
+
+  g_transform.x += dx * g_transform.scale;
+  g_transform.y += dy * g_transform.scale;
+  update_transform();
+}
+
+bool is_scaling() {
+  return g_transform.scale != FIXED_ONE;
 }
 
-void end_scale() {
-  g_draw_scale = 1.0f;
-  update_scale();
+bool is_transformed() {
+  return g_transform_mode != TransformMode::IDENTITY;
 }
 
-void begin_screen_scale(float scale) {
-  g_screen_scale = scale;
-  update_scale();
+static int transform_x(int x) {
+  return ((int64_t)x * g_transform.scale + g_transform.x) >> FIXED_SHIFT;
 }
 
-void end_screen_scale() {
-  g_screen_scale = 1.0f;
-  update_scale();
+static int transform_y(int y) {
+  return ((int64_t)y * g_transform.scale + g_transform.y) >> FIXED_SHIFT;
+}
+
+static int transform_size(int size) {
+  return ((int64_t)size * g_transform.scale) >> FIXED_SHIFT;
+}
+
+void set_specialized_draw_paths(bool enabled) {
+  g_specialized_paths = enabled;
+}
+
+void set_screen_offset(int dy, int dx_bytes) {
+  lcd_set_viewport(dy, dx_bytes);
 }
 
 void begin_mask(DrawMask draw_mask) {
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::BEGIN_MASK);
+    command.mask = draw_mask;
+    display_list_record(command);
+  }
+
   g_should_mask = true;
   g_draw_mask = draw_mask;
 }
 
 void end_mask() {
+  if (display_list_is_recording()) {
+    display_list_record(make_command(DrawOp::END_MASK));
+  }
+
   g_should_mask = false;
 }
 
+static int64_t floor_div(int64_t a, int64_t b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+Surface* create_surface() {
+  constexpr int SCREEN_WORDS = (LCD_WIDTH + 31) / 32 * LCD_HEIGHT;
+  int words = lcd_raster_words();
+  uint32_t* raster = new (std::nothrow) uint32_t[words]();
+  if (!raster) {
+    return nullptr;
+  }
+  Surface* surface = new (std::nothrow) Surface{ raster, words == SCREEN_WORDS };
+  if (!surface) {
+    delete[] raster;
+  }
+  return surface;
+}
+
+void destroy_surface(Surface* surface) {
+  delete[] surface->raster;
+  delete surface;
+}
+
+void begin_surface(const Surface& surface) {
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::BEGIN_SURFACE);
+    command.raster = surface.raster;
+    display_list_record(command);
+    return;
+  }
+
+  lcd_set_target(surface.raster);
+}
+
+void end_surface() {
+  if (display_list_is_recording()) {
+    display_list_record(make_command(DrawOp::END_SURFACE));
+    return;
+  }
+
+  lcd_set_target(nullptr);
+}
+
+void draw_surface(const Surface& surface) {
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::SURFACE);
+    command.raster = surface.raster;
+    record_command(command, 0, LCD_HEIGHT - 1);
+    return;
+  }
+
+  static const DrawMask all_pixels = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+  const uint8_t* mask = g_should_mask ? g_draw_mask.mask : all_pixels.mask;
+  if (g_transform_mode == TransformMode::IDENTITY) {
+    lcd_copy_raster(surface.raster, mask);
+    return;
+  }
+
+  // Nearest neighbour: the source pixel under the center of each screen pixel, clamped
+  // to the surface so its edges stretch over whatever the transform uncovers
+  static DRAW_THREAD_LOCAL int16_t source_rows[LCD_HEIGHT];
+  static DRAW_THREAD_LOCAL int16_t source_columns[LCD_WIDTH];
+  for (int y = 0; y < LCD_HEIGHT; y++) {
+    int64_t source = floor_div(((int64_t)y << FIXED_SHIFT) + FIXED_ONE / 2 - g_transform.y, g_transform.scale);
+    source_rows[y] = std::clamp<int64_t>(source, 0, LCD_HEIGHT - 1);
+  }
+  for (int x = 0; x < LCD_WIDTH; x++) {
+    int64_t source = floor_div(((int64_t)x << FIXED_SHIFT) + FIXED_ONE / 2 - g_transform.x, g_transform.scale);
+    source_columns[x] = std::clamp<int64_t>(source, 0, LCD_WIDTH - 1);
+  }
+  lcd_copy_raster_scaled(surface.raster, source_rows, source_columns, mask);
+}
+
 static void draw_pixel_masked(int x, int y, int color) {
   if (g_should_mask) {
     int masked_bit = 0x80 >> (x & 7);
@@ -78,16 +291,230 @@ static void draw_pixel_masked(int x, int y, int color) {
   }
 }
 
+/**
+ * @brief Draw state for one primitive: how coordinates are transformed and whether pixels
+ * go through the draw mask, fixed at compile time so the per-pixel loops don't branch on it.
+ */
+template <TransformMode T, bool M>
+struct DrawState {
+  static int map_x(int x) {
+    switch (T) {
+      case TransformMode::INTEGER:
+        return x * g_int_scale + g_int_x;
+      case TransformMode::FIXED:
+        return transform_x(x);
+      default:
+        return x;
+    }
+  }
+
+  static int map_y(int y) {
+    switch (T) {
+      case TransformMode::INTEGER:
+        return y * g_int_scale + g_int_y;
+      case TransformMode::FIXED:
+        return transform_y(y);
+      default:
+        return y;
+    }
+  }
+
+  static int map_size(int size) {
+    switch (T) {
+      case TransformMode::INTEGER:
+        return size * g_int_scale;
+      case TransformMode::FIXED:
+        return transform_size(size);
+      default:
+        return size;
+    }
+  }
+
+  static void plot(int x, int y, int color) {
+    if (!M || (g_draw_mask.mask[y & 7] & (0x80 >> (x & 7)))) {
+      lcd_draw_pixel(x, y, color);
+    }
+  }
+};
+
+/**
+ * @brief Draw state read from the globals on every call, the way all primitives worked
+ * before they were specialized. Kept for comparison, see set_specialized_draw_paths().
+ */
+struct DynamicDrawState {
+  static int map_x(int x) {
+    return g_transform_mode != TransformMode::IDENTITY ? transform_x(x) : x;
+  }
+
+  static int map_y(int y) {
+    return g_transform_mode != TransformMode::IDENTITY ? transform_y(y) : y;
+  }
+
+  static int map_size(int size) {
+    return g_transform_mode != TransformMode::IDENTITY ? transform_size(size) : size;
+  }
+
+  static void plot(int x, int y, int color) {
+    draw_pixel_masked(x, y, color);
+  }
+};
+
+/**
+ * @brief Calls draw with the DrawState matching the current transform and mask.
+ */
+template <typename F>
+static auto with_draw_state(F&& draw) {
+  if (!g_specialized_paths) {
+    return draw(DynamicDrawState{});
+  }
+
+  switch (g_transform_mode) {
+    case TransformMode::INTEGER:
+      return g_should_mask ? draw(DrawState<TransformMode::INTEGER, true>{}) : draw(DrawState<TransformMode::INTEGER, false>{});
+    case TransformMode::FIXED:
+      return g_should_mask ? draw(DrawState<TransformMode::FIXED, true>{}) : draw(DrawState<TransformMode::FIXED, false>{});
+    default:
+      return g_should_mask ? draw(DrawState<TransformMode::IDENTITY, true>{}) : draw(DrawState<TransformMode::IDENTITY, false>{});
+  }
+}
+
+/**
+ * @brief Fills pixels x0 to x1 - 1 of line y, honoring the draw mask.
+ */
+static void fill_span_masked(int y, int x0, int x1, uint8_t pattern, int color) {
+  if (g_should_mask) {
+    pattern &= g_draw_mask.mask[y & 7];
+  }
+  lcd_fill_span_pattern(y, x0, x1, pattern, color);
+}
+
 void draw_pixel(int x, int y, int color) {
-  if (g_should_scale) {
-    x = ((x - CENTER_X) * g_scale) + CENTER_X;
-    y = ((y - CENTER_Y) * g_scale) + CENTER_Y;
+  if (display_list_is_recording()) {
+    record_command(make_command(DrawOp::PIXEL, x, y, 0, 0, color), transform_y(y), transform_y(y));
+    return;
+  }
+
+  with_draw_state([=](auto state) {
+    using State = decltype(state);
+    State::plot(State::map_x(x), State::map_y(y), color);
+  });
+}
+
+/**
+ * @brief Writes up to 32 sprite pixels starting at x, as lcd_write_bits() does.
+ * @param bits Sprite pixels, first one in bit 31.
+ * @param mask Sprite pixels to draw at all.
+ */
+static void blit_bits(int y, int x, uint32_t bits, uint32_t mask, BlitOp op) {
+  if (g_should_mask) {
+    // Line the 8-pixel draw mask up with x
+    uint32_t pattern = g_draw_mask.mask[y & 7] * 0x01010101u;
+    int phase = x & 7;
+    mask &= phase ? (pattern << phase) | (pattern >> (32 - phase)) : pattern;
+  }
+
+  switch (op) {
+    case BlitOp::COPY:
+    case BlitOp::MASKED:
+      lcd_write_bits(y, x, bits & mask, ~bits & mask, 0);
+      break;
+    case BlitOp::OR:
+      lcd_write_bits(y, x, bits & mask, 0, 0);
+      break;
+    case BlitOp::AND:
+      lcd_write_bits(y, x, 0, ~bits & mask, 0);
+      break;
+    case BlitOp::XOR:
+      lcd_write_bits(y, x, 0, 0, bits & mask);
+      break;
   }
+}
 
-  draw_pixel_masked(x, y, color);
+/**
+ * @brief Reads 32 pixels of a sprite row starting at pixel x, first one in bit 31.
+ */
+static uint32_t read_sprite_bits(const uint8_t* row, int row_bytes, int x) {
+  uint32_t bits = 0;
+  for (int i = 0; i < 4; i++) {
+    int b = (x >> 3) + i;
+    bits = (bits << 8) | (b < row_bytes ? row[b] : 0);
+  }
+  return bits;
+}
+
+static void draw_sprite_scaled(const Sprite& sprite, int x, int y, BlitOp op) {
+  int row_bytes = (sprite.width + 7) / 8;
+  int x_destination = transform_x(x);
+  int y_destination = transform_y(y);
+  int width_destination = transform_size(sprite.width);
+  int height_destination = transform_size(sprite.height);
+  // Source pixels per destination pixel, Q16.16
+  int32_t source_step = ((int64_t)FIXED_ONE << FIXED_SHIFT) / g_transform.scale;
+
+  int row_end = std::min(height_destination, LCD_HEIGHT - y_destination);
+  int col_start = std::max(0, -x_destination);
+  int col_end = std::min(width_destination, LCD_WIDTH - x_destination);
+  for (int row = std::max(0, -y_destination); row < row_end; row++) {
+    int source_row = std::min((int)(((int64_t)row * source_step) >> FIXED_SHIFT), sprite.height - 1);
+    const uint8_t* data = &sprite.data[source_row * row_bytes];
+    const uint8_t* mask = sprite.mask ? &sprite.mask[source_row * row_bytes] : nullptr;
+    for (int col = col_start; col < col_end; col++) {
+      int source_col = std::min((int)(((int64_t)col * source_step) >> FIXED_SHIFT), sprite.width - 1);
+      uint8_t source_bit = 0x80 >> (source_col & 7);
+      uint32_t bits = (data[source_col >> 3] & source_bit) ? 0x80000000u : 0;
+      bool drawn = op != BlitOp::MASKED || (mask[source_col >> 3] & source_bit);
+      blit_bits(y_destination + row, x_destination + col, bits, drawn ? 0x80000000u : 0, op);
+    }
+  }
+}
+
+void draw_sprite(const Sprite& sprite, int x, int y, BlitOp op) {
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::SPRITE, x, y, 0, 0, (int)op);
+    command.sprite = &sprite;
+    record_command(command, transform_y(y), transform_y(y) + transform_size(sprite.height) - 1);
+    return;
+  }
+
+  if (is_scaling()) {
+    draw_sprite_scaled(sprite, x, y, op);
+    return;
+  }
+
+  x = transform_x(x);
+  y = transform_y(y);
+
+  // Whole 32-pixel chunks of each row that touch the screen
+  int col_start = std::max(0, -x) & ~31;
+  int col_end = std::min((int)sprite.width, LCD_WIDTH - x);
+  int row_bytes = (sprite.width + 7) / 8;
+  int row_start = std::max(0, -y);
+  int row_end = std::min((int)sprite.height, LCD_HEIGHT - y);
+  for (int row = row_start; row < row_end; row++) {
+    const uint8_t* data = &sprite.data[row * row_bytes];
+    const uint8_t* mask = sprite.mask ? &sprite.mask[row * row_bytes] : nullptr;
+    for (int col = col_start; col < col_end; col += 32) {
+      uint32_t bits = read_sprite_bits(data, row_bytes, col);
+      uint32_t width_mask = sprite.width - col >= 32 ? ~0u : ~(~0u >> (sprite.width - col));
+      if (op == BlitOp::MASKED) {
+        width_mask &= read_sprite_bits(mask, row_bytes, col);
+        if (width_mask == 0) {
+          continue;
+        }
+      }
+      blit_bits(y + row, x + col, bits, width_mask, op);
+    }
+  }
 }
 
 void fill_scrfeen_buffer(int color) {
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::FILL_SCREEN, 0, 0, 0, 0, color);
+    command.pattern = g_should_mask;
+    record_command(command, 0, LCD_HEIGHT - 1);
+    return;
+  }
+
   if (g_should_mask) {
     for (size_t i = 0; i < LCD_HEIGHT; i++) {
       lcd_fill_line(i, g_draw_mask.mask[i & 7], color);
@@ -98,199 +525,715 @@ void fill_scrfeen_buffer(int color) {
 }
 
 void draw_rectangle(const Rectangle& rect, int color) {
-  int rx, ry, rw, rh;
-  if (g_should_scale) {
-    rx = (rect.x - CENTER_X) * g_scale + CENTER_X;
-    ry = (rect.y - CENTER_Y) * g_scale + CENTER_Y;
-    rw = rect.width * g_scale;
-    rh = rect.height * g_scale;
-  } else {
-    rx = rect.x;
-    ry = rect.y;
-    rw = rect.width;
-    rh = rect.height;
+  if (display_list_is_recording()) {
+    int y = transform_y(rect.y);
+    record_command(make_command(DrawOp::RECT, rect.x, rect.y, rect.width, rect.height, color),
+                   y, y + transform_size(rect.height) - 1);
+    return;
   }
 
-  for (int i = rx; i < rx + rw; i++) {
-    for (int j = ry; j < ry + rh; j++) {
-      draw_pixel_masked(i, j, color);
-    }
+  int rx = transform_x(rect.x);
+  int ry = transform_y(rect.y);
+  int rw = transform_size(rect.width);
+  int rh = transform_size(rect.height);
+
+  int y_end = std::min(ry + rh, LCD_HEIGHT);
+  for (int j = std::max(ry, 0); j < y_end; j++) {
+    fill_span_masked(j, rx, rx + rw, 0xff, color);
   }
 }
 
 void draw_rectangle_checkerboard(int posX, int posY, int width, int height) {
-  if (g_should_scale) {
-    posX = (posX - CENTER_X) * g_scale + CENTER_X;
-    posY = (posY - CENTER_Y) * g_scale + CENTER_Y;
-    width = width * g_scale;
-    height = height * g_scale;
+  if (display_list_is_recording()) {
+    int y = transform_y(posY);
+    record_command(make_command(DrawOp::CHECKERBOARD, posX, posY, width, height), y, y + transform_size(height) - 1);
+    return;
   }
 
-  for (int i = posX; i < posX + width; i++) {
-    for (int j = posY; j < posY + height; j++) {
-      if ((i + j) & 1) {
-        draw_pixel_masked(i, j, 0);
-      }
-    }
+  posX = transform_x(posX);
+  posY = transform_y(posY);
+  width = transform_size(width);
+  height = transform_size(height);
+
+  // Pixels with odd x + y are cleared: 01010101 on even lines, 10101010 on odd ones
+  int y_end = std::min(posY + height, LCD_HEIGHT);
+  for (int j = std::max(posY, 0); j < y_end; j++) {
+    fill_span_masked(j, posX, posX + width, (j & 1) ? 0xaa : 0x55, 0);
   }
 }
 
-void draw_rectangle_lines(int posX, int posY, int width, int height, int color) {
-  if (g_should_scale) {
-    posX = (posX - CENTER_X) * g_scale + CENTER_X;
-    posY = (posY - CENTER_Y) * g_scale + CENTER_Y;
-    width = width * g_scale;
-    height = height * g_scale;
+/**
+ * @brief Narrows [first, last] to the steps i of a run p0 + i * step (step is -1, 0 or 1)
+ * that stay within 0 to size - 1. Leaves first > last if none do.
+ */
+static void clip_run(int p0, int step, int size, int& first, int& last) {
+  if (step > 0) {
+    first = std::max(first, -p0);
+    last = std::min(last, size - 1 - p0);
+  } else if (step < 0) {
+    first = std::max(first, p0 - (size - 1));
+    last = std::min(last, p0);
+  } else if (p0 < 0 || p0 >= size) {
+    first = last + 1;
   }
+}
+
+template <typename State>
+static void draw_rectangle_lines_impl(int posX, int posY, int width, int height, int color) {
+  posX = State::map_x(posX);
+  posY = State::map_y(posY);
+  width = State::map_size(width);
+  height = State::map_size(height);
 
   // Draw top horizontal line
-  for (int x = posX; x < posX + width; x++) {
-    draw_pixel_masked(x, posY, color);
-  }
+  fill_span_masked(posY, posX, posX + width, 0xff, color);
 
   // Draw bottom horizontal line
-  for (int x = posX; x < posX + width; x++) {
-    draw_pixel_masked(x, posY + height - 1, color);
-  }
+  fill_span_masked(posY + height - 1, posX, posX + width, 0xff, color);
+
+  int y_start = std::max(posY, 0);
+  int y_end = std::min(posY + height, LCD_HEIGHT);
 
   // Draw left vertical line
-  for (int y = posY; y < posY + height; y++) {
-    draw_pixel_masked(posX, y, color);
+  if (posX >= 0 && posX < LCD_WIDTH) {
+    for (int y = y_start; y < y_end; y++) {
+      State::plot(posX, y, color);
+    }
   }
 
   // Draw right vertical line
-  for (int y = posY; y < posY + height; y++) {
-    draw_pixel_masked(posX + width - 1, y, color);
+  int right = posX + width - 1;
+  if (right >= 0 && right < LCD_WIDTH) {
+    for (int y = y_start; y < y_end; y++) {
+      State::plot(right, y, color);
+    }
   }
 }
 
-void draw_rectangle_lines_pattern(const Rectangle& rect, uint8_t pattern_size, uint8_t pattern) {
-  int rx, ry, rw, rh;
-  if (g_should_scale) {
-    rx = (rect.x - CENTER_X) * g_scale + CENTER_X;
-    ry = (rect.y - CENTER_Y) * g_scale + CENTER_Y;
-    rw = rect.width * g_scale;
-    rh = rect.height * g_scale;
-  } else {
-    rx = rect.x;
-    ry = rect.y;
-    rw = rect.width;
-    rh = rect.height;
+void draw_rectangle_lines(int posX, int posY, int width, int height, int color) {
+  if (display_list_is_recording()) {
+    int y = transform_y(posY);
+    record_command(make_command(DrawOp::RECT_LINES, posX, posY, width, height, color), y, y + transform_size(height) - 1);
+    return;
   }
 
+  with_draw_state([=](auto state) {
+    draw_rectangle_lines_impl<decltype(state)>(posX, posY, width, height, color);
+  });
+}
+
+/**
+ * @brief Draws count pattern pixels from x, y on, one step of step_x, step_y apart,
+ * skipping the ones off the screen without losing the pattern phase.
+ * @return pattern_state after the run
+ */
+template <typename State>
+static int draw_pattern_run(int x, int y, int step_x, int step_y, int count,
+                            int pattern_state, uint8_t pattern_size, uint8_t pattern) {
+  int first = 0;
+  int last = count - 1;
+  clip_run(x, step_x, LCD_WIDTH, first, last);
+  clip_run(y, step_y, LCD_HEIGHT, first, last);
+  for (int i = first; i <= last; i++) {
+    int color = (pattern >> (7 - ((pattern_state + i) % pattern_size))) & 1;
+    State::plot(x + i * step_x, y + i * step_y, color);
+  }
+  return pattern_state + std::max(count, 0);
+}
+
+template <typename State>
+static void draw_rectangle_lines_pattern_impl(int rx, int ry, int rw, int rh, uint8_t pattern_size, uint8_t pattern) {
+  // Clockwise from the top left corner, the pattern continuing around the corners
   int pattern_state = 0;
-  auto get_color = [&pattern_state, pattern, pattern_size]() {
-    return (pattern >> (7 - (pattern_state++ % pattern_size))) & 1;
-  };
+  pattern_state = draw_pattern_run<State>(rx, ry, 1, 0, rw, pattern_state, pattern_size, pattern);
+  pattern_state = draw_pattern_run<State>(rx + rw - 1, ry, 0, 1, rh, pattern_state, pattern_size, pattern);
+  pattern_state = draw_pattern_run<State>(rx + rw - 1, ry + rh - 1, -1, 0, rw, pattern_state, pattern_size, pattern);
+  draw_pattern_run<State>(rx, ry + rh - 1, 0, -1, rh, pattern_state, pattern_size, pattern);
+}
 
-  for (int x = rx; x < rx + rw; x++) {
-    draw_pixel_masked(x, ry, get_color());
+void draw_rectangle_lines_pattern(const Rectangle& rect, uint8_t pattern_size, uint8_t pattern) {
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::RECT_LINES_PATTERN, rect.x, rect.y, rect.width, rect.height);
+    command.pattern = pattern;
+    command.pattern_size = pattern_size;
+    int y = transform_y(rect.y);
+    record_command(command, y, y + transform_size(rect.height) - 1);
+    return;
   }
 
-  for (int y = ry; y < ry + rh; y++) {
-    draw_pixel_masked(rx + rw - 1, y, get_color());
+  int rx = transform_x(rect.x);
+  int ry = transform_y(rect.y);
+  int rw = transform_size(rect.width);
+  int rh = transform_size(rect.height);
+
+  // Transformed once above, only the pixel loop is specialized
+  with_draw_state([=](auto state) {
+    draw_rectangle_lines_pattern_impl<decltype(state)>(rx, ry, rw, rh, pattern_size, pattern);
+  });
+}
+
+/**
+ * @brief Part of a Bresenham line that is on the screen: the state of the line loop at
+ * step first (the pixel, error and directions), and the last visible step. Steps count
+ * along the major axis, step major ends the line.
+ */
+struct LineClip {
+  int x, y;
+  int err;
+  int dx, dy;
+  int sx, sy;
+  int first, last;
+  int major;
+};
+
+/**
+ * @brief Clips a line drawn by the Bresenham loop of draw_line() to the screen.
+ *
+ * Liang-Barsky on the step index: the major axis coordinate moves by one every step, and
+ * after k steps the loop has moved ceil((k * minor - major / 2) / major) pixels along the
+ * minor axis, so both screen edges become a range of steps. The loop state at the first
+ * visible step follows from the same formula, which puts every remaining pixel exactly
+ * where the unclipped loop would.
+ * @return false if no pixel of the line is on the screen
+ */
+static bool clip_line(int x0, int y0, int x1, int y1, LineClip& clip) {
+  clip.dx = abs(x1 - x0);
+  clip.sx = x0 < x1 ? 1 : -1;
+  clip.dy = abs(y1 - y0);
+  clip.sy = y0 < y1 ? 1 : -1;
+
+  bool x_major = clip.dx > clip.dy;
+  int64_t major = x_major ? clip.dx : clip.dy;
+  int64_t minor = x_major ? clip.dy : clip.dx;
+  clip.major = major;
+
+  int first = 0;
+  int last = major;
+  clip_run(x_major ? x0 : y0, x_major ? clip.sx : clip.sy, x_major ? LCD_WIDTH : LCD_HEIGHT, first, last);
+  if (first > last) {
+    return false;
+  }
+
+  // Minor axis pixels moved that stay on the screen, as a range of steps
+  int minor_start = 0;
+  int minor_end = major;
+  clip_run(x_major ? y0 : x0, x_major ? clip.sy : clip.sx, x_major ? LCD_HEIGHT : LCD_WIDTH, minor_start, minor_end);
+  if (minor == 0) {
+    if (minor_start > 0 || minor_end < 0) {
+      return false;
+    }
+  } else {
+    first = std::max<int64_t>(first, floor_div((minor_start - 1) * major + major / 2, minor) + 1);
+    last = std::min<int64_t>(last, floor_div(minor_end * major + major / 2, minor));
   }
+  if (first > last) {
+    return false;
+  }
+
+  int moved = major == 0 ? 0 : floor_div(first * minor - major / 2 + major - 1, major);
+  if (x_major) {
+    clip.x = x0 + clip.sx * first;
+    clip.y = y0 + clip.sy * moved;
+    clip.err = clip.dx / 2 - first * clip.dy + moved * clip.dx;
+  } else {
+    clip.x = x0 + clip.sx * moved;
+    clip.y = y0 + clip.sy * first;
+    clip.err = -(clip.dy / 2) + first * clip.dx - moved * clip.dy;
+  }
+  clip.first = first;
+  clip.last = last;
+  return true;
+}
 
-  for (int x = rx + rw - 1; x >= rx; x--) {
-    draw_pixel_masked(x, ry + rh - 1, get_color());
+template <typename State>
+static void draw_line_impl(int x0, int y0, int x1, int y1, int color) {
+  x0 = State::map_x(x0);
+  y0 = State::map_y(y0);
+  x1 = State::map_x(x1);
+  y1 = State::map_y(y1);
+
+  LineClip c;
+  if (!clip_line(x0, y0, x1, y1, c)) {
+    return;
   }
 
-  for (int y = ry + rh - 1; y >= ry; y--) {
-    draw_pixel_masked(rx, y, get_color());
+  int e2;
+  for (int step = c.first;; step++) {
+    State::plot(c.x, c.y, color);
+    if (step == c.last) break;
+    e2 = c.err;
+    if (e2 > -c.dx) {
+      c.err -= c.dy;
+      c.x += c.sx;
+    }
+    if (e2 < c.dy) {
+      c.err += c.dx;
+      c.y += c.sy;
+    }
   }
 }
 
 void draw_line(int x0, int y0, int x1, int y1, int color) {
-  if (g_should_scale) {
-    x0 = ((x0 - CENTER_X) * g_scale) + CENTER_X;
-    y0 = ((y0 - CENTER_Y) * g_scale) + CENTER_Y;
-    x1 = ((x1 - CENTER_X) * g_scale) + CENTER_X;
-    y1 = ((y1 - CENTER_Y) * g_scale) + CENTER_Y;
-  }
-
-  int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-  int dy = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-  int err = (dx > dy ? dx : -dy) / 2, e2;
-
-  for (;;) {
-    draw_pixel_masked(x0, y0, color);
-    if (x0 == x1 && y0 == y1) break;
-    e2 = err;
-    if (e2 > -dx) {
-      err -= dy;
-      x0 += sx;
+  if (display_list_is_recording()) {
+    record_command(make_command(DrawOp::LINE, x0, y0, x1, y1, color), transform_y(y0), transform_y(y1));
+    return;
+  }
+
+  with_draw_state([=](auto state) {
+    draw_line_impl<decltype(state)>(x0, y0, x1, y1, color);
+  });
+}
+
+/**
+ * @brief Pattern line between two screen points, see draw_line_pattern().
+ */
+template <typename State>
+static int draw_pattern_line(int x0, int y0, int x1, int y1, int pattern_state, uint8_t pattern_size, uint8_t pattern) {
+  // The pattern advances one pixel per step, whether the pixel is on the screen or not
+  LineClip c;
+  if (!clip_line(x0, y0, x1, y1, c)) {
+    return pattern_state + std::max(abs(x1 - x0), abs(y1 - y0)) + 1;
+  }
+
+  int e2;
+  for (int step = c.first;; step++) {
+    int color = (pattern >> (7 - ((pattern_state + step) % pattern_size))) & 1;
+    State::plot(c.x, c.y, color);
+    if (step == c.last) break;
+    e2 = c.err;
+    if (e2 > -c.dx) {
+      c.err -= c.dy;
+      c.x += c.sx;
     }
-    if (e2 < dy) {
-      err += dx;
-      y0 += sy;
+    if (e2 < c.dy) {
+      c.err += c.dx;
+      c.y += c.sy;
     }
   }
+
+  return pattern_state + c.major + 1;
+}
+
+template <typename State>
+static int draw_line_pattern_impl(int x0, int y0, int x1, int y1, int pattern_state, uint8_t pattern_size, uint8_t pattern) {
+  return draw_pattern_line<State>(State::map_x(x0), State::map_y(y0), State::map_x(x1), State::map_y(y1),
+                                  pattern_state, pattern_size, pattern);
 }
 
 int draw_line_pattern(int x0, int y0, int x1, int y1, int pattern_state, uint8_t pattern_size, uint8_t pattern) {
-  if (g_should_scale) {
-    x0 = ((x0 - CENTER_X) * g_scale) + CENTER_X;
-    y0 = ((y0 - CENTER_Y) * g_scale) + CENTER_Y;
-    x1 = ((x1 - CENTER_X) * g_scale) + CENTER_X;
-    y1 = ((y1 - CENTER_Y) * g_scale) + CENTER_Y;
-  }
-
-  int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-  int dy = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-  int err = (dx > dy ? dx : -dy) / 2, e2;
-
-  for (;;) {
-    int color = (pattern >> (7 - (pattern_state++ % pattern_size))) & 1;
-    draw_pixel_masked(x0, y0, color);
-    if (x0 == x1 && y0 == y1) break;
-    e2 = err;
-    if (e2 > -dx) {
-      err -= dy;
-      x0 += sx;
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::LINE_PATTERN, x0, y0, x1, y1);
+    command.pattern = pattern;
+    command.pattern_size = pattern_size;
+    command.value = pattern_state;
+    record_command(command, transform_y(y0), transform_y(y1));
+    // The state the line leaves the pattern in, as if it was drawn
+    return pattern_state + std::max(abs(transform_x(x1) - transform_x(x0)), abs(transform_y(y1) - transform_y(y0))) + 1;
+  }
+
+  return with_draw_state([=](auto state) {
+    return draw_line_pattern_impl<decltype(state)>(x0, y0, x1, y1, pattern_state, pattern_size, pattern);
+  });
+}
+
+// Fraction bits of the conic rasterizer's coordinates, fewer for arcs too far out to fit
+constexpr int CONIC_MAX_SHIFT = 20;
+// Fraction bits of t in the conic rasterizer
+constexpr int CONIC_T_SHIFT = 20;
+// Steps are 2^-step_shift long in t, step_shift going up to this; arcs moving faster than
+// a pixel per step then are joined by lines
+constexpr int CONIC_MAX_STEP_SHIFT = 9;
+
+/**
+ * @brief Fixed point state of draw_conic_arc(). Each coordinate p relative to the center
+ * follows p'' = -p on an ellipse and p'' = p on a hyperbola, stepped with epsilon =
+ * 2^-step_shift as
+ *
+ *   p += d >> step_shift;  d -= p >> step_shift  (d += for a hyperbola)
+ *
+ * With d started half a step ahead this puts step n exactly at t = n * step_t, where
+ * 2 cos(step_t) = 2 - epsilon^2 (2 cosh(step_t) = 2 + epsilon^2), rounding aside: the
+ * points don't spiral or drift however many steps are taken.
+ */
+struct ConicStepper {
+  int32_t center_x, center_y;
+  int32_t x, y;    // point relative to the center
+  int32_t dx, dy;  // derivative by t, half a step ahead
+  int shift;       // fraction bits of all of the above
+  int step_shift;
+  int32_t end;     // last t, CONIC_T_SHIFT fraction bits
+};
+
+// Fraction bits of ConicStepTable::sine_factor
+constexpr int CONIC_FACTOR_SHIFT = 30;
+
+/**
+ * @brief Tables for each step_shift: step_t with CONIC_T_SHIFT fraction bits, from the
+ * series of 2 asin(epsilon / 2) and 2 asinh(epsilon / 2), and sqrt(1 - epsilon^2 / 4)
+ * (sqrt(1 + epsilon^2 / 4)) with CONIC_FACTOR_SHIFT fraction bits, the ratio of d to the
+ * derivative by t.
+ */
+struct ConicStepTable {
+  int32_t step_t[2][CONIC_MAX_STEP_SHIFT + 1];
+  int32_t sine_factor[2][CONIC_MAX_STEP_SHIFT + 1];
+};
+
+static constexpr double constexpr_sqrt(double value) {
+  double root = 1.0;
+  for (int i = 0; i < 8; i++) {
+    root = (root + value / root) / 2;
+  }
+  return root;
+}
+
+static constexpr ConicStepTable make_conic_step_table() {
+  ConicStepTable table{};
+  for (int step_shift = 0; step_shift <= CONIC_MAX_STEP_SHIFT; step_shift++) {
+    double e = 1.0 / (1 << step_shift);
+    double e2 = e * e;
+    double odd = e * e2 / 24 + 5 * e * e2 * e2 * e2 / 7168;
+    double even = e + 3 * e * e2 * e2 / 640;
+    table.step_t[0][step_shift] = (int32_t)((even + odd) * (1 << CONIC_T_SHIFT) + 0.5);
+    table.step_t[1][step_shift] = (int32_t)((even - odd) * (1 << CONIC_T_SHIFT) + 0.5);
+    table.sine_factor[0][step_shift] = (int32_t)(constexpr_sqrt(1 - e2 / 4) * (1 << CONIC_FACTOR_SHIFT) + 0.5);
+    table.sine_factor[1][step_shift] = (int32_t)(constexpr_sqrt(1 + e2 / 4) * (1 << CONIC_FACTOR_SHIFT) + 0.5);
+  }
+  return table;
+}
+
+static constexpr ConicStepTable conic_step_table = make_conic_step_table();
+
+static ConicArc transform_conic_arc(const ConicArc& arc) {
+  float scale = (float)g_transform.scale / FIXED_ONE;
+  ConicArc transformed = arc;
+  transformed.center = { arc.center.x * scale + (float)g_transform.x / FIXED_ONE,
+                         arc.center.y * scale + (float)g_transform.y / FIXED_ONE };
+  transformed.u = arc.u * scale;
+  transformed.v = arc.v * scale;
+  return transformed;
+}
+
+/**
+ * @brief Range of one coordinate of a conic arc, given the center and the u and v of the
+ * coordinate.
+ */
+static void get_conic_extent(const ConicArc& arc, float center, float u, float v, float& low, float& high) {
+  if (!arc.hyperbola) {
+    // The whole ellipse, a part of it is never drawn
+    float radius = sqrtf(u * u + v * v);
+    low = center - radius;
+    high = center + radius;
+    return;
+  }
+
+  // Either end, or where the derivative u * sinh(t) + v * cosh(t) is 0
+  float end = u * coshf(arc.end) + v * sinhf(arc.end);
+  low = std::min(u, end);
+  high = std::max(u, end);
+  if (fabsf(v) < fabsf(u)) {
+    float t = atanhf(-v / u);
+    if (t > 0.0f && t < arc.end) {
+      float turn = u * coshf(t) + v * sinhf(t);
+      low = std::min(low, turn);
+      high = std::max(high, turn);
     }
-    if (e2 < dy) {
-      err += dx;
-      y0 += sy;
+  }
+  low += center;
+  high += center;
+}
+
+Rectangle get_conic_arc_rect(const ConicArc& arc) {
+  float low_x, high_x, low_y, high_y;
+  get_conic_extent(arc, arc.center.x, arc.u.x, arc.v.x, low_x, high_x);
+  get_conic_extent(arc, arc.center.y, arc.u.y, arc.v.y, low_y, high_y);
+
+  // A pixel more on each side for the rounding of the fixed point steps
+  float x = floorf(low_x) - 1;
+  float y = floorf(low_y) - 1;
+  return { x, y, floorf(high_x) + 2 - x, floorf(high_y) + 2 - y };
+}
+
+/**
+ * @brief Sets up the stepping of a transformed arc.
+ * @return false if the arc is too large to step in 32 bits
+ */
+static bool init_conic_stepper(const ConicArc& arc, ConicStepper& stepper) {
+  if (!(arc.end > 0.0f && arc.end < (float)(1 << (30 - CONIC_T_SHIFT)))) {
+    return false;
+  }
+
+  // Largest offset from the center and fastest movement along either axis, at the ends of
+  // a hyperbola branch; both are the radius of that coordinate's cosine wave on an ellipse
+  float reach = 0.0f;
+  float speed = 0.0f;
+  float cosh_end = arc.hyperbola ? coshf(arc.end) : 0.0f;
+  float sinh_end = arc.hyperbola ? sinhf(arc.end) : 0.0f;
+  const float axes[2][2] = { { arc.u.x, arc.v.x }, { arc.u.y, arc.v.y } };
+  for (const auto& axis : axes) {
+    float u = axis[0];
+    float v = axis[1];
+    if (arc.hyperbola) {
+      reach = std::max({ reach, fabsf(u), fabsf(u * cosh_end + v * sinh_end) });
+      speed = std::max({ speed, fabsf(v), fabsf(u * sinh_end + v * cosh_end) });
+    } else {
+      float radius = sqrtf(u * u + v * v);
+      reach = std::max(reach, radius);
+      speed = std::max(speed, radius);
     }
   }
 
-  return pattern_state;
+  // Offsets, derivatives and center all have to fit in 30 bits with the fraction
+  float largest = std::max(fabsf(arc.center.x), fabsf(arc.center.y)) + 2.0f * std::max(reach, speed) + 2.0f;
+  int shift = CONIC_MAX_SHIFT;
+  while (shift > 0 && largest * (float)(1 << shift) >= (float)(1 << 30)) {
+    shift--;
+  }
+  if (!(largest * (float)(1 << shift) < (float)(1 << 30))) {
+    return false;
+  }
+
+  // At most a pixel for the first step, see conic_step_length()
+  int step_shift = 0;
+  auto first_step_length = [&](int shift_to_try) {
+    float epsilon = 1.0f / (1 << shift_to_try);
+    return std::max(fabsf(arc.v.x) + fabsf(arc.u.x) * epsilon, fabsf(arc.v.y) + fabsf(arc.u.y) * epsilon) * epsilon;
+  };
+  while (step_shift < CONIC_MAX_STEP_SHIFT && first_step_length(step_shift) > 1.0f) {
+    step_shift++;
+  }
+
+  // d starts as (p(step_t) - p(0)) / epsilon
+  float half_step = (arc.hyperbola ? 0.5f : -0.5f) / (1 << step_shift);
+  float sine_factor = (float)conic_step_table.sine_factor[arc.hyperbola][step_shift] / (1 << CONIC_FACTOR_SHIFT);
+  float one = (float)(1 << shift);
+  stepper.center_x = lroundf(arc.center.x * one);
+  stepper.center_y = lroundf(arc.center.y * one);
+  stepper.x = lroundf(arc.u.x * one);
+  stepper.y = lroundf(arc.u.y * one);
+  stepper.dx = lroundf((arc.u.x * half_step + arc.v.x * sine_factor) * one);
+  stepper.dy = lroundf((arc.u.y * half_step + arc.v.y * sine_factor) * one);
+  stepper.shift = shift;
+  stepper.step_shift = step_shift;
+  stepper.end = (int32_t)(arc.end * (1 << CONIC_T_SHIFT));
+  return true;
 }
 
 /**
- * @brief Draws a single character bitmap to the LCD with scaling.
+ * @brief How far a conic step of 2^-step_shift can move along either axis: the derivative,
+ * plus how much it changes over the step, times the step.
  */
-void draw_char(int draw_x, int draw_y, int scale, uint8_t char_code, int color) {
-  int index = char_code - FONT_START_CHAR;
-  if (index < 0 || index >= FONT_MAP_SIZE) {
-    index = 0;
+static int32_t conic_step_length(const ConicStepper& s, int step_shift) {
+  int32_t length_x = abs(s.dx) + abs(s.x >> step_shift);
+  int32_t length_y = abs(s.dy) + abs(s.y >> step_shift);
+  return std::max(length_x, length_y) >> step_shift;
+}
+
+/**
+ * @brief How many pixels x, y is off the screen along the farther axis, 0 on it.
+ */
+static int get_distance_to_screen(int x, int y) {
+  return std::max({ 0, -x, x - (LCD_WIDTH - 1), -y, y - (LCD_HEIGHT - 1) });
+}
+
+template <typename State, bool Hyperbola>
+static void draw_conic_arc_impl(ConicStepper s, const ConicArc& arc) {
+  const int32_t one = 1 << s.shift;
+  const int pattern_count = arc.pattern_count;
+  int pattern_index = 0;
+  int32_t next_pattern_t = s.end / pattern_count;
+  int pattern_state = 0;
+
+  auto plot = [&](int x, int y) {
+    uint8_t pattern_size = arc.pattern_sizes[pattern_index];
+    int color = (arc.patterns[pattern_index] >> (7 - (pattern_state % pattern_size))) & 1;
+    State::plot(x, y, color);
+    pattern_state++;
+  };
+
+  // The last pixel plotted, and the pixel the arc has reached since. That one is only
+  // plotted once the arc moves on from it and away from the last one, so pixels the arc
+  // merely cuts the corner of are left out.
+  int last_x = (s.center_x + s.x) >> s.shift;
+  int last_y = (s.center_y + s.y) >> s.shift;
+  int reached_x = last_x;
+  int reached_y = last_y;
+  plot(last_x, last_y);
+
+  int32_t t = 0;
+  int32_t step_t = conic_step_table.step_t[Hyperbola][s.step_shift];
+  while (t < s.end) {
+    s.x += s.dx >> s.step_shift;
+    s.y += s.dy >> s.step_shift;
+    if (Hyperbola) {
+      s.dx += s.x >> s.step_shift;
+      s.dy += s.y >> s.step_shift;
+    } else {
+      s.dx -= s.x >> s.step_shift;
+      s.dy -= s.y >> s.step_shift;
+    }
+    t += step_t;
+
+    while (t >= next_pattern_t && pattern_index < pattern_count - 1) {
+      pattern_index++;
+      next_pattern_t = (int64_t)s.end * (pattern_index + 1) / pattern_count;
+    }
+
+    int x = (s.center_x + s.x) >> s.shift;
+    int y = (s.center_y + s.y) >> s.shift;
+    if (x == reached_x && y == reached_y) {
+      continue;
+    }
+
+    // Keep steps as long as they can be without moving more than a pixel, or off the
+    // screen, without getting on it
+    int distance = get_distance_to_screen(x, y);
+    int32_t longest = distance > 2 ? (distance - 1) << s.shift : one;
+    int new_shift = s.step_shift;
+    if (s.step_shift > 0 && conic_step_length(s, s.step_shift - 1) <= longest) {
+      new_shift--;
+    }
+    while (new_shift < CONIC_MAX_STEP_SHIFT && conic_step_length(s, new_shift) > longest) {
+      new_shift++;
+    }
+    if (new_shift != s.step_shift) {
+      // Back from d to the derivative at p, then half the new step ahead
+      int32_t from = conic_step_table.sine_factor[Hyperbola][s.step_shift];
+      int32_t to = conic_step_table.sine_factor[Hyperbola][new_shift];
+      if (Hyperbola) {
+        s.dx = (int64_t)(s.dx - (s.x >> (s.step_shift + 1))) * to / from + (s.x >> (new_shift + 1));
+        s.dy = (int64_t)(s.dy - (s.y >> (s.step_shift + 1))) * to / from + (s.y >> (new_shift + 1));
+      } else {
+        s.dx = (int64_t)(s.dx + (s.x >> (s.step_shift + 1))) * to / from - (s.x >> (new_shift + 1));
+        s.dy = (int64_t)(s.dy + (s.y >> (s.step_shift + 1))) * to / from - (s.y >> (new_shift + 1));
+      }
+      s.step_shift = new_shift;
+      step_t = conic_step_table.step_t[Hyperbola][new_shift];
+    }
+
+    if (abs(x - last_x) > 1 || abs(y - last_y) > 1) {
+      if (reached_x != last_x || reached_y != last_y) {
+        plot(reached_x, reached_y);
+        last_x = reached_x;
+        last_y = reached_y;
+      }
+      int length = std::max(abs(x - last_x), abs(y - last_y));
+      if (length > 1) {
+        // A step longer than a pixel, redrawing the last pixel as it was. The pattern moves
+        // on as if it was drawn off the screen too.
+        if (length < get_distance_to_screen(last_x, last_y)) {
+          pattern_state += length;
+        } else {
+          pattern_state = draw_pattern_line<State>(last_x, last_y, x, y, pattern_state - 1,
+                                                   arc.pattern_sizes[pattern_index], arc.patterns[pattern_index]);
+        }
+        last_x = x;
+        last_y = y;
+      }
+    }
+    reached_x = x;
+    reached_y = y;
   }
 
-  const uint8_t* char_data = charmap[index];
+  if (reached_x != last_x || reached_y != last_y) {
+    plot(reached_x, reached_y);
+  }
+}
 
-  // Use fixed-point arithmetics (16.16)
-  // TODO: use struct/unions?
-  int32_t g_scale_fp = (int32_t)(g_scale * 65536);
-  int total_scale = scale * g_scale_fp;
+void draw_conic_arc(const ConicArc& arc) {
+  ConicArc transformed = transform_conic_arc(arc);
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::CONIC_ARC);
+    command.conic = &arc;
+    Rectangle rect = get_conic_arc_rect(transformed);
+    record_command(command, (int)rect.y, (int)(rect.y + rect.height) - 1);
+    return;
+  }
 
-  int x_destination = (((draw_x - CENTER_X) * g_scale_fp) >> 16) + CENTER_X;
-  int y_destination = (((draw_y - CENTER_Y) * g_scale_fp) >> 16) + CENTER_Y;
+  ConicStepper stepper;
+  if (arc.pattern_count == 0 || !init_conic_stepper(transformed, stepper)) {
+    return;
+  }
 
-  int width_destination = (FONT_CHAR_WIDTH * total_scale) >> 16;
-  int height_destination = (FONT_CHAR_HEIGHT * total_scale) >> 16;
+  // Transformed once above, only the pixel loop is specialized
+  with_draw_state([&](auto state) {
+    if (arc.hyperbola) {
+      draw_conic_arc_impl<decltype(state), true>(stepper, arc);
+    } else {
+      draw_conic_arc_impl<decltype(state), false>(stepper, arc);
+    }
+  });
+}
+
+// Glyph scales with pre-expanded rows, 1 to GLYPH_ATLAS_SCALES
+constexpr int GLYPH_ATLAS_SCALES = 3;
+
+/**
+ * @brief charmap glyphs widened for each integer scale into one 32-bit word per glyph
+ * row, leftmost pixel in bit 31, ready for lcd_write_bits(). Columns are sampled exactly
+ * as draw_char_impl() samples them; rows are repeated while blitting.
+ */
+struct GlyphAtlas {
+  uint32_t rows[GLYPH_ATLAS_SCALES][FONT_MAP_SIZE][FONT_CHAR_HEIGHT];
+};
+
+static constexpr GlyphAtlas make_glyph_atlas() {
+  GlyphAtlas atlas{};
+  for (int scale = 1; scale <= GLYPH_ATLAS_SCALES; scale++) {
+    int32_t source_step_fp = FIXED_ONE / scale;
+    for (int index = 0; index < FONT_MAP_SIZE; index++) {
+      for (int row = 0; row < FONT_CHAR_HEIGHT; row++) {
+        uint32_t bits = 0;
+        for (int col = 0; col < FONT_CHAR_WIDTH * scale; col++) {
+          int source_col = (col * source_step_fp) >> FIXED_SHIFT;
+          if (charmap[index][row] & (0x80 >> source_col)) {
+            bits |= 0x80000000u >> col;
+          }
+        }
+        atlas.rows[scale - 1][index][row] = bits;
+      }
+    }
+  }
+  return atlas;
+}
 
-  int32_t source_step_fp = (1 << 16) / scale;
-  source_step_fp = ((int64_t)source_step_fp << 16) / g_scale_fp;
+// Generated at compile time, kept in flash
+static constexpr GlyphAtlas glyph_atlas = make_glyph_atlas();
 
-  int32_t source_row_fp = 0;
-  for (int row = 0; row < height_destination; row++) {
+/**
+ * @brief Draws an unscaled glyph from the atlas a row at a time, setting its pixels to
+ * color and leaving the rest.
+ */
+static void draw_glyph_rows(int index, int scale, int x, int y, int color) {
+  const uint32_t* rows = glyph_atlas.rows[scale - 1][index];
+  int32_t source_step_fp = FIXED_ONE / scale;
+  int row_start = std::max(0, -y);
+  int row_end = std::min(FONT_CHAR_HEIGHT * scale, LCD_HEIGHT - y);
+  for (int row = row_start; row < row_end; row++) {
+    uint32_t bits = rows[(row * source_step_fp) >> FIXED_SHIFT];
+    if (bits) {
+      blit_bits(y + row, x, color ? bits : 0, bits, BlitOp::COPY);
+    }
+  }
+}
+
+template <typename State>
+static void draw_char_impl(const uint8_t* char_data, int x_destination, int y_destination,
+                           int width_destination, int height_destination, int32_t source_step_fp, int color) {
+  // Only the rows and columns on the screen, starting at the same source positions
+  int row_start = std::max(0, -y_destination);
+  int row_end = std::min(height_destination, LCD_HEIGHT - y_destination);
+  int col_start = std::max(0, -x_destination);
+  int col_end = std::min(width_destination, LCD_WIDTH - x_destination);
+
+  int32_t source_row_fp = row_start * source_step_fp;
+  for (int row = row_start; row < row_end; row++) {
     int source_row = source_row_fp >> 16;
     uint8_t row_byte = char_data[source_row];
-    int32_t source_col_fp = 0;
-    for (int col = 0; col < width_destination; col++) {
+    int32_t source_col_fp = col_start * source_step_fp;
+    for (int col = col_start; col < col_end; col++) {
       int source_col = source_col_fp >> 16;
       if (row_byte & (0x80 >> source_col)) {
-        draw_pixel_masked(x_destination + col, y_destination + row, color);
+        State::plot(x_destination + col, y_destination + row, color);
       }
       source_col_fp += source_step_fp;
     }
@@ -298,6 +1241,56 @@ void draw_char(int draw_x, int draw_y, int scale, uint8_t char_code, int color)
   }
 }
 
+/**
+ * @brief Draws a single character bitmap to the LCD with scaling.
+ */
+void draw_char(int draw_x, int draw_y, int scale, uint8_t char_code, int color) {
+  if (display_list_is_recording()) {
+    DrawCommand command = make_command(DrawOp::CHAR, draw_x, draw_y, color, 0, scale);
+    command.pattern = char_code;
+    int y = transform_y(draw_y);
+    record_command(command, y, y + ((FONT_CHAR_HEIGHT * scale * g_transform.scale) >> FIXED_SHIFT) - 1);
+    return;
+  }
+
+  int index = char_code - FONT_START_CHAR;
+  if (index < 0 || index >= FONT_MAP_SIZE) {
+    index = 0;
+  }
+
+  const uint8_t* char_data = charmap[index];
+
+  // Glyph scale times the transform scale, Q16.16
+  int32_t total_scale = scale * g_transform.scale;
+
+  int x_destination = transform_x(draw_x);
+  int y_destination = transform_y(draw_y);
+
+  int width_destination = (FONT_CHAR_WIDTH * total_scale) >> FIXED_SHIFT;
+  int height_destination = (FONT_CHAR_HEIGHT * total_scale) >> FIXED_SHIFT;
+
+  // Glyphs off the screen are skipped whole
+  if (x_destination >= LCD_WIDTH || x_destination + width_destination <= 0 ||
+      y_destination >= LCD_HEIGHT || y_destination + height_destination <= 0) {
+    return;
+  }
+
+  // Zoom transitions fall through to per-pixel sampling
+  if (!is_scaling() && scale <= GLYPH_ATLAS_SCALES) {
+    draw_glyph_rows(index, scale, x_destination, y_destination, color);
+    return;
+  }
+
+  int32_t source_step_fp = FIXED_ONE / scale;
+  source_step_fp = ((int64_t)source_step_fp << FIXED_SHIFT) / g_transform.scale;
+
+  // Scaled above in fixed point, only the mask is taken from the draw state
+  with_draw_state([=](auto state) {
+    draw_char_impl<decltype(state)>(char_data, x_destination, y_destination,
+                                    width_destination, height_destination, source_step_fp, color);
+  });
+}
+
 void print_text(int x, int y, int scale, const char* text, int color) {
   if (scale < 1) return;
 
@@ -19,20 +19,128 @@ constexpr DrawMask operator~(const DrawMask& m) {
            (uint8_t)~m.mask[7] };
 }
 
-void begin_scale(float scale);
+/**
+ * @brief 1-bpp image, rows of (width + 7) / 8 bytes with the leftmost pixel in the most
+ * significant bit. Set bits are drawn with color 1, clear bits with color 0.
+ */
+struct Sprite {
+  uint16_t width;
+  uint16_t height;
+  const uint8_t* data;
+  const uint8_t* mask;  // same layout as data, pixels drawn by BlitOp::MASKED
+};
+
+/**
+ * @brief How draw_sprite() combines sprite pixels with the screen.
+ */
+enum class BlitOp {
+  COPY,    // every sprite pixel replaces the screen
+  OR,      // set pixels become color 1, the rest stay
+  AND,     // clear pixels become color 0, the rest stay
+  XOR,     // set pixels invert the screen
+  MASKED,  // like COPY, only where the sprite mask is set
+};
+
+// Q16.16 fixed point, used for draw transforms
+constexpr int FIXED_SHIFT = 16;
+constexpr int32_t FIXED_ONE = 1 << FIXED_SHIFT;
 
-void end_scale();
+constexpr int32_t to_fixed(float value) {
+  return (int32_t)(value * FIXED_ONE);
+}
+
+constexpr int DRAW_TRANSFORM_DEPTH = 8;
+
+/**
+ * @brief Saves the current draw transform, restored by the matching pop_transform().
+ * Transforms nest up to DRAW_TRANSFORM_DEPTH deep.
+ */
+void push_transform();
 
-void begin_screen_scale(float scale);
+void pop_transform();
 
-void end_screen_scale();
+/**
+ * @brief Scales everything drawn from now on around the screen center, on top of the
+ * current transform. Scales within 1% of 1 are ignored.
+ * @param scale Scale factor in Q16.16.
+ */
+void scale_transform(int32_t scale);
+
+/**
+ * @brief Moves everything drawn from now on by dx, dy pixels, on top of the current
+ * transform (so the offset is scaled by it).
+ */
+void translate_transform(int dx, int dy);
+
+/**
+ * @brief Returns true while the current transform changes draw sizes.
+ */
+bool is_scaling();
+
+/**
+ * @brief Returns true while the current transform moves or scales anything.
+ */
+bool is_transformed();
+
+/**
+ * @brief Selects how the per-pixel loops of the draw functions handle scale and mask:
+ * specialized for the current state once per call (default), or checking the state for
+ * every pixel. Both draw the same pixels; the slow path is kept for benchmarks.
+ */
+void set_specialized_draw_paths(bool enabled);
+
+/**
+ * @brief Moves the whole picture on the display by dy lines and dx_bytes * 8 pixels
+ * without redrawing it, until set back to 0, 0. See lcd_set_viewport().
+ */
+void set_screen_offset(int dy, int dx_bytes);
 
 void begin_mask(DrawMask draw_mask);
 
 void end_mask();
 
+/**
+ * @brief Offscreen 1-bpp raster with the framebuffer's layout and lines (one strip in
+ * strip mode), so a screen can be drawn unmasked and composited afterwards.
+ */
+struct Surface {
+  uint32_t* raster;
+  bool whole_screen;  // false in strip mode, where contents don't outlive the strip
+};
+
+/**
+ * @brief Allocates a cleared surface, nullptr if there isn't enough memory. About 12 KB
+ * outside strip mode, so better allocated once and kept.
+ */
+Surface* create_surface();
+
+void destroy_surface(Surface* surface);
+
+/**
+ * @brief Sends draw calls to the surface instead of the framebuffer until end_surface().
+ * Surfaces don't nest.
+ */
+void begin_surface(const Surface& surface);
+
+void end_surface();
+
+/**
+ * @brief Copies a surface over the framebuffer, only the pixels the draw mask allows.
+ * Untransformed, whole words are copied at a time; otherwise the surface is scaled with
+ * nearest neighbour sampling through per-row and per-column source tables, and needs to
+ * hold the whole screen.
+ */
+void draw_surface(const Surface& surface);
+
 void draw_pixel(int x, int y, int color);
 
+/**
+ * @brief Draws a sprite with its top left corner at x, y. Unscaled, each sprite row goes
+ * to the framebuffer 32 pixels at a time, shifted to any x; while scaling, the sprite is
+ * resampled pixel by pixel with nearest neighbour.
+ */
+void draw_sprite(const Sprite& sprite, int x, int y, BlitOp op);
+
 void fill_scrfeen_buffer(int color);
 
 void draw_rectangle(const Rectangle& rect, int color);
@@ -50,6 +158,43 @@ void draw_line(int x0, int y0, int x1, int y1, int color);
 
 int draw_line_pattern(int x0, int y0, int x1, int y1, int pattern_state, uint8_t pattern_size, uint8_t pattern);
 
+/**
+ * @brief Arc of an ellipse or of one branch of a hyperbola: the points
+ * center + u * cos(t) + v * sin(t), or center + u * cosh(t) + v * sinh(t) for a hyperbola,
+ * for t from 0 to end. u goes from the center to the first point, v is the derivative by t
+ * there, so the two pick the size, rotation and direction of the arc.
+ */
+struct ConicArc {
+  Vector2 center;
+  Vector2 u;
+  Vector2 v;
+  float end;
+  bool hyperbola;
+  // The arc is split into pattern_count parts of equal t, drawn with the patterns in turn
+  const uint8_t* patterns;
+  const uint8_t* pattern_sizes;
+  uint8_t pattern_count;
+};
+
+/**
+ * @brief Draws a conic arc with pattern lines, the pattern continuing along the whole arc.
+ * The arc is walked with an integer recurrence in about a pixel per step, so drawing costs
+ * about as much as its visible length and needs no trig per pixel. Off the screen and on
+ * very large arcs, steps get longer and are joined by lines. The arc must stay valid until
+ * the frame is replayed.
+ */
+void draw_conic_arc(const ConicArc& arc);
+
+/**
+ * @brief Returns the pixels draw_conic_arc() can touch, without the transform.
+ */
+Rectangle get_conic_arc_rect(const ConicArc& arc);
+
+/**
+ * @brief Draws a single character at x, y, scale times the font size.
+ */
+void draw_char(int draw_x, int draw_y, int scale, uint8_t char_code, int color);
+
 /**
  * @brief Prints a C-string of text to the LCD with scaling.
  * Only supports manual newlines ('\n').
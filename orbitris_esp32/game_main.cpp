@@ -1,7 +1,11 @@
 #include "game_main.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 
+#include "const.h"
+#include "display_list.h"
 #include "game_screen.h"
 #include "game_over_screen.h"
 #include "game_utils.h"
@@ -10,6 +14,7 @@
 #include "screen.h"
 #include "stats.h"
 #include "table_math.h"
+#include "tetramino.h"
 #include "transition.h"
 
 Screen* current_screen = nullptr;
@@ -26,6 +31,7 @@ TransitionParams default_params = { TransitionKind::ZOOM_IN, 1.0f / 25 };
 TransitionRule rules[]{
   { screens::pause_screen, screens::game_screen, { TransitionKind::NONE, 1.0f } },
   { screens::game_screen, screens::pause_screen, { TransitionKind::NONE, 1.0f } },
+  { screens::pause_screen, screens::menu_screen, { TransitionKind::SLIDE_DOWN, 1.0f / 30 } },
   { screens::game_screen, screens::game_over_screen, { TransitionKind::ZOOM_OUT, 1.0f / 60 } },
   { screens::game_over_screen, screens::game_screen, { TransitionKind::ZOOM_IN, 1.0f / 25 } }
 };
@@ -33,6 +39,15 @@ TransitionRule rules[]{
 Stats stats{};
 
 static bool in_transition = false;
+static bool display_list_enabled = true;
+// Screen that drew the last frame on its own, nullptr if it was a transition
+static Screen* last_drawn_screen = nullptr;
+// Lines the current frame changes, see Screen::get_damage()
+static int damage_first = 0;
+static int damage_count = LCD_HEIGHT;
+
+extern void lcd_get_raster_lines(int* first, int* count);
+extern void lcd_set_clip_lines(int first, int count);
 
 static TransitionParams find_transition_params(Screen* from, Screen* to) {
   // Linear complexity, whatever
@@ -54,11 +69,13 @@ void update_screen() {
 }
 
 void draw_screen() {
-  current_screen->draw();
+  current_screen->draw_with_underlay();
 }
 
 void init_game() {
   init_trig_tables();
+  init_tile_sprites();
+  init_transitions();
 
   screens::game_screen = new GameScreen(stats);
   screens::game_over_screen = new GameOverScreen(stats);
@@ -68,9 +85,10 @@ void init_game() {
   current_screen = screens::menu_screen;
   current_screen->init();
   in_transition = false;
+  last_drawn_screen = nullptr;
 }
 
-void update_draw_frame() {
+void update_frame() {
   if (in_transition) {
     in_transition = !update_transition();
     if (!in_transition) {
@@ -80,9 +98,76 @@ void update_draw_frame() {
     update_screen();
   }
 
+  Screen* drawn_screen = in_transition ? nullptr : current_screen;
+  set_previous_frame_kept(drawn_screen != nullptr && drawn_screen == last_drawn_screen);
+  last_drawn_screen = drawn_screen;
+
+  // After the line above, so the old screen draws itself whole into the snapshot
+  if (in_transition) {
+    prepare_transition_frame();
+  }
+
+  damage_first = 0;
+  damage_count = LCD_HEIGHT;
+  Rectangle damage{};
+  if (is_previous_frame_kept() && current_screen->get_damage(damage)) {
+    // The panel takes whole lines, so the damage is redrawn as the band of lines it spans
+    bool empty = damage.width <= 0 || damage.height <= 0;
+    int top = std::clamp((int)floorf(damage.y), 0, LCD_HEIGHT);
+    int bottom = std::clamp((int)ceilf(damage.y + damage.height), top, LCD_HEIGHT);
+    damage_first = top;
+    damage_count = empty ? 0 : bottom - top;
+  }
+}
+
+void get_frame_damage_lines(int* first, int* count) {
+  *first = damage_first;
+  *count = damage_count;
+}
+
+static void draw_current_frame() {
   if (in_transition) {
     draw_transition();
   } else {
     draw_screen();
   }
 }
+
+void record_draw_frame() {
+  if (!display_list_enabled) {
+    return;
+  }
+
+  display_list_begin();
+  draw_current_frame();
+  display_list_end();
+}
+
+void draw_frame() {
+  int first = 0;
+  int count = LCD_HEIGHT;
+  lcd_get_raster_lines(&first, &count);
+  int top = std::max(first, damage_first);
+  int bottom = std::min(first + count, damage_first + damage_count);
+  if (bottom <= top) {
+    return;
+  }
+
+  lcd_set_clip_lines(top, bottom - top);
+  if (display_list_enabled && !display_list_overflowed()) {
+    display_list_replay();
+  } else {
+    draw_current_frame();
+  }
+  lcd_set_clip_lines(first, count);
+}
+
+void set_display_list_enabled(bool enabled) {
+  display_list_enabled = enabled;
+}
+
+void update_draw_frame() {
+  update_frame();
+  record_draw_frame();
+  draw_frame();
+}
@@ -2,4 +2,34 @@
 
 void init_game();
 
+/**
+ * @brief Advances the game by one frame without drawing.
+ */
+void update_frame();
+
+/**
+ * @brief Records the draw calls of the current frame into the display list, once per
+ * update. Does nothing with the display list disabled.
+ */
+void record_draw_frame();
+
+/**
+ * @brief Returns the framebuffer lines the current frame changes: the lines spanned by the
+ * damage the screen reported (see Screen::get_damage()), or all of them.
+ */
+void get_frame_damage_lines(int* first, int* count);
+
+/**
+ * @brief Draws the current frame by replaying the display list, or directly if it is
+ * disabled or the frame didn't fit. Only the lines get_frame_damage_lines() returns are
+ * cleared and drawn, the rest keep the previous frame. Doesn't change any state, so it
+ * can be replayed, e.g. once per strip by lcd_update_strips().
+ */
+void draw_frame();
+
+/**
+ * @brief Draws frames straight from the screens instead of through the display list.
+ */
+void set_display_list_enabled(bool enabled);
+
 void update_draw_frame();
@@ -24,6 +24,11 @@ Screen *GameOverScreen::update() {
 }
 
 void GameOverScreen::draw() const {
+  // Nothing moves after the first frame
+  if (is_previous_frame_kept()) {
+    return;
+  }
+
   fill_scrfeen_buffer(1);
 
   const int text_x = LCD_WIDTH / 2 - text_size_.x / 2;
@@ -31,3 +36,8 @@ void GameOverScreen::draw() const {
 
   print_text(text_x, text_y, 2, score_buffer_, 0);
 }
+
+bool GameOverScreen::get_damage(Rectangle &area) const {
+  area = {};
+  return true;
+}
@@ -16,6 +16,8 @@ public:
 
   virtual void draw() const override;
 
+  virtual bool get_damage(Rectangle& area) const override;
+
 private:
   const Stats& stats_;
   Vector2 text_size_;
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstddef>
 
+#include "charmap.h"
 #include "draw.h"
 #include "explosion.h"
 #include "input.h"
@@ -34,7 +35,8 @@ constexpr float SCALE_MIN = 0.33f;
 constexpr float SCALE_MAX = 1.0f;
 constexpr float ZOOM_SPEED = 0.005f;
 
-constexpr auto trajectory_size = 50;
+// Largest semi-major axis of a trajectory in pixels, see update_trajectory()
+constexpr float MAX_SEMI_MAJOR_AXIS = 65536.0f;
 
 constexpr float PROGRESS_SPEED = 0.05f;
 constexpr float DIST_THRESHOLD = 0.0001f;
@@ -43,12 +45,25 @@ constexpr float MAX_PIECE_DISTANCE_SQUARE = LCD_HEIGHT * LCD_HEIGHT * 4;
 
 constexpr Vector2 NEXT_TETRAMINO_POS = { 80, 20 };
 
+constexpr int SCORE_TEXT_X = 310;
+constexpr int SCORE_TEXT_Y = 8;
+constexpr int SCORE_TEXT_SCALE = 2;
+// Up to the right edge, whatever the number of digits
+constexpr Rectangle SCORE_TEXT_RECT = { SCORE_TEXT_X - 1, SCORE_TEXT_Y - 1, LCD_WIDTH - SCORE_TEXT_X + 1,
+                                        FONT_CHAR_HEIGHT * SCORE_TEXT_SCALE + 2 };
+
 const uint8_t patterns[] = { 0x00, 0x11, 0x24, 0x55, 0xd8, 0xee, 0xf0, 0xf8 };
 const uint8_t pattern_sizes[] = { 8, 8, 6, 8, 6, 8, 5, 6 };
 constexpr auto patterns_count = std::size(patterns);
 
 constexpr int GAME_OVER_ANIMATION_FRAMES = 60;
 
+// Screen shake offsets per frame in lines, applied by the display without redrawing.
+// Vertical only: lines moved to other panel lines are only resent where they differ,
+// while a horizontal move changes every line and would resend the whole frame.
+constexpr int SHAKE_DY[] = { 4, -4, 3, -3, 2, -2, 1, -1 };
+constexpr int SHAKE_FRAMES = std::size(SHAKE_DY);
+
 const char* status_text_heres_your_piece = "Here's your piece\nDon't lose it again!";
 
 GameScreen::GameScreen(Stats& stats)
@@ -66,6 +81,7 @@ void GameScreen::init() {
   is_exploding_ = false;
   is_playing_game_over_animation_ = false;
   game_over_animation_frame_ = 0;
+  shake_frame_ = SHAKE_FRAMES;
 
   generate_next_tetramino();
 
@@ -76,6 +92,8 @@ void GameScreen::init() {
   target_zoom_ = 1.0f;
 
   tilemap_.init();
+  update_trajectory();
+  damage_whole_screen_ = true;
 }
 
 Screen* GameScreen::update() {
@@ -114,13 +132,15 @@ Screen* GameScreen::update() {
   }
 
   if (is_playing_game_over_animation_) {
+    if (game_over_animation_frame_ == 0) {
+      start_shake();
+    }
     game_over_animation_frame_++;
     if (game_over_animation_frame_ >= GAME_OVER_ANIMATION_FRAMES && !is_exploding_) {
       init_explosion(tilemap_, star_pos_);
       is_exploding_ = true;
     }
   }
-
   update_sliding_tetramino(sliding_tetramino_);
 
   detect_piece_too_far(active_tetramino_);
@@ -138,7 +158,10 @@ Screen* GameScreen::update() {
     active_tetramino_.rot_index = (active_tetramino_.rot_index + 1) % 4;
   }
 
+  update_trajectory();
+
   if (is_key_pressed(ESP_KEY_A)) {
+    stop_shake();
     return screens::pause_screen;
   }
 
@@ -148,10 +171,17 @@ Screen* GameScreen::update() {
 
   if (is_exploding_) {
     if (update_explosion()) {
+      stop_shake();
       return screens::game_over_screen;
     }
   }
 
+  // Points only come from cleared lines
+  if (tilemap_.game_points > stats_.game_points) {
+    start_shake();
+  }
+  update_shake();
+
   // update stats
   stats_.game_points = tilemap_.game_points;
 
@@ -175,28 +205,39 @@ Screen* GameScreen::update() {
     status_text_frame_++;
   }
 
+  update_damage();
   return this;
 }
 
 void GameScreen::draw() const {
   fill_scrfeen_buffer(1);
 
-  begin_scale(current_zoom_);
+  push_transform();
+  scale_transform(to_fixed(current_zoom_));
   draw_trajectory();
-  draw_boundaries();
+  // Unscaled, the boundaries at rest and the tiles are blits of the tilemap layers. The
+  // boundaries go under the tetraminos and the tiles over them
+  bool draw_layer = !is_exploding_ && !is_scaling();
+  if (draw_layer && game_over_animation_frame_ == 0) {
+    tilemap_.draw_boundary_layer();
+  } else {
+    draw_boundaries();
+  }
   draw_tetramino(active_tetramino_);
   draw_tetramino(sliding_tetramino_);
   if (is_exploding_) {
     draw_explosion();
+  } else if (draw_layer) {
+    tilemap_.draw_layer();
   } else {
     tilemap_.draw();
   }
-  end_scale();
+  pop_transform();
 
   constexpr auto buf_size = 100;
   char score_buf[buf_size]{};
   snprintf(score_buf, buf_size, "%7d", tilemap_.game_points);
-  print_text(310, 8, 2, score_buf, 0);
+  print_text(SCORE_TEXT_X, SCORE_TEXT_Y, SCORE_TEXT_SCALE, score_buf, 0);
   print_text(10, 8, 2, "Next:", 0);
 
   if (status_text_frame_ < STATUS_TEXT_FRAMES) {
@@ -208,9 +249,101 @@ void GameScreen::draw() const {
   draw_tetramino(next_tetramino_);
 }
 
+bool GameScreen::get_damage(Rectangle& area) const {
+  if (damage_whole_screen_) {
+    return false;
+  }
+
+  area = damage_rect_;
+  return true;
+}
+
 void GameScreen::close() {
 }
 
+void GameScreen::update_damage() {
+  // Scaled or animated, nearly everything moves
+  damage_whole_screen_ = current_zoom_ != 1.0f || drawn_zoom_ != 1.0f || game_over_animation_frame_ > 0 ||
+                         is_exploding_;
+  drawn_zoom_ = current_zoom_;
+
+  Rectangle damage{};
+  Rectangle trajectory_rect = get_trajectory_rect();
+  damage = get_union_rec(damage, get_union_rec(drawn_trajectory_rect_, trajectory_rect));
+  drawn_trajectory_rect_ = trajectory_rect;
+
+  Rectangle active_rect = get_tetramino_rect(active_tetramino_);
+  damage = get_union_rec(damage, get_union_rec(drawn_active_rect_, active_rect));
+  drawn_active_rect_ = active_rect;
+
+  Rectangle sliding_rect = get_tetramino_rect(sliding_tetramino_);
+  damage = get_union_rec(damage, get_union_rec(drawn_sliding_rect_, sliding_rect));
+  drawn_sliding_rect_ = sliding_rect;
+
+  tilemap_.collect_dirty_rect(damage);
+
+  if (next_tetramino_.block != drawn_next_block_) {
+    ActiveTetramino drawn_next = next_tetramino_;
+    drawn_next.block = drawn_next_block_;
+    damage = get_union_rec(damage, get_union_rec(get_tetramino_rect(drawn_next), get_tetramino_rect(next_tetramino_)));
+    drawn_next_block_ = next_tetramino_.block;
+  }
+
+  if (tilemap_.game_points != drawn_points_) {
+    damage = get_union_rec(damage, SCORE_TEXT_RECT);
+    drawn_points_ = tilemap_.game_points;
+  }
+
+  // Another text of the same size changes the pixels too, nullptr while none is shown
+  Rectangle status_rect = get_status_text_rect();
+  const char* status_text = status_text_frame_ < STATUS_TEXT_FRAMES ? status_text_ : nullptr;
+  if (status_text != drawn_status_text_ || status_rect.x != drawn_status_rect_.x ||
+      status_rect.y != drawn_status_rect_.y || status_rect.width != drawn_status_rect_.width ||
+      status_rect.height != drawn_status_rect_.height) {
+    damage = get_union_rec(damage, get_union_rec(drawn_status_rect_, status_rect));
+    drawn_status_rect_ = status_rect;
+    drawn_status_text_ = status_text;
+  }
+
+  damage_rect_ = damage;
+}
+
+Rectangle GameScreen::get_trajectory_rect() const {
+  return has_trajectory_ ? get_conic_arc_rect(trajectory_) : Rectangle{};
+}
+
+Rectangle GameScreen::get_status_text_rect() const {
+  if (status_text_frame_ >= STATUS_TEXT_FRAMES) {
+    return {};
+  }
+
+  constexpr int text_y_offset = 10;
+  Vector2 text_size = measure_text(status_text_, 2);
+  return { LCD_WIDTH / 2 - text_size.x / 2 - 1, LCD_HEIGHT - text_size.y - text_y_offset - 1,
+           text_size.x + 2, text_size.y + 2 };
+}
+
+void GameScreen::start_shake() {
+  shake_frame_ = 0;
+}
+
+void GameScreen::update_shake() {
+  if (shake_frame_ < SHAKE_FRAMES) {
+    set_screen_offset(SHAKE_DY[shake_frame_], 0);
+    shake_frame_++;
+  } else if (shake_frame_ == SHAKE_FRAMES) {
+    set_screen_offset(0, 0);
+    shake_frame_++;
+  }
+}
+
+void GameScreen::stop_shake() {
+  if (shake_frame_ <= SHAKE_FRAMES) {
+    set_screen_offset(0, 0);
+  }
+  shake_frame_ = SHAKE_FRAMES + 1;
+}
+
 /**
  * @brief Return resolution of the simulation (runs per frame). Resolution
  * depends on the distance from the "star". Higher resolution = more accurate
@@ -325,51 +458,77 @@ void GameScreen::detect_piece_too_far(const ActiveTetramino& block) {
   }
 }
 
-void GameScreen::draw_trajectory() const {
+void GameScreen::update_trajectory() {
+  has_trajectory_ = false;
   OrbitalElements elements = calc_orbital_elements(planet_state_, STAR_MASS);
-  if (elements.eccentricity >= 1.0f) {
-    // TODO: draw open orbit!
-    return;
+  float e = elements.eccentricity;
+  float p = elements.semi_latus_rectum / DIST_SCALE;
+  // Near a parabola the center of the conic runs off to infinity; a hyperbola just past it
+  // looks the same on the screen
+  if (fabsf(1.0f - e * e) * MAX_SEMI_MAJOR_AXIS < p) {
+    e = sqrtf(1.0f + p / MAX_SEMI_MAJOR_AXIS);
   }
-
-  // Calculate the step size for the true anomaly
+  bool hyperbola = e > 1.0f;
   int dir = planet_state_.angle.speed > 0 ? 1 : -1;
-  const float d_nu = 2.0f * (float)M_PI / (float)trajectory_size * dir;
-
-  Vector2 cur{};
-  Vector2 prev{};
-
-  int pattern_state = 0;
-  for (int i = 0; i <= trajectory_size; ++i) {
-    // Start drawing from the current planet position
-    const float nu = planet_state_.angle.value - elements.arg_periapsis + i * d_nu;
-
-    // Calculate Distance (r) using the Polar Equation of a Conic Section
-    // r(nu) = p / (1 + e * cos(nu))
-    float cos_nu = approx_cos(nu);
-    float r_distance = elements.semi_latus_rectum / (1.0f + elements.eccentricity * cos_nu);
-
-    // Calculate the Absolute Angle (phi)
-    // phi = omega + nu
-    const float phi = elements.arg_periapsis + nu;
-
-    // Convert Polar coordinates to Cartesian
-    float cos_phi = approx_cos(phi);
-    float sin_phi = approx_sin(phi);
-
-    // Scale the distance and offset center
-    float dist_to_scale = r_distance / DIST_SCALE;
-    cur.x = star_pos_.x + dist_to_scale * cos_phi;
-    cur.y = star_pos_.y + dist_to_scale * sin_phi;
-
-    // Draw the Line Segment
-    if (i > 0) {
-      size_t pattern_index = (size_t)remap(i, 0, trajectory_size, 0, patterns_count - 1);
-      pattern_state = draw_line_pattern((int)prev.x, (int)prev.y, (int)cur.x, (int)cur.y,
-                                        pattern_state, pattern_sizes[pattern_index], patterns[pattern_index]);
+
+  // Where the planet is on the conic: the eccentric anomaly E of an ellipse, or the
+  // hyperbolic anomaly F of a hyperbola, from the true anomaly nu
+  const float nu = planet_state_.angle.value - elements.arg_periapsis;
+  float cos_nu = approx_cos(nu);
+  float sin_nu = approx_sin(nu);
+  float denominator = 1.0f + e * cos_nu;
+  if (denominator <= 0.0f) {
+    return;
+  }
+  float root = sqrtf(fabsf(1.0f - e * e));
+  float cos_anomaly = (e + cos_nu) / denominator;    // cos(E) or cosh(F)
+  float sin_anomaly = root * sin_nu / denominator;  // sin(E) or sinh(F)
+
+  // Semi-axes in screen pixels, a along the periapsis direction
+  float a = p / (root * root);
+  float b = a * root;
+  Vector2 periapsis_dir = { approx_cos(elements.arg_periapsis), approx_sin(elements.arg_periapsis) };
+  Vector2 normal_dir = { -periapsis_dir.y, periapsis_dir.x };
+
+  // Relative to the star, an ellipse is a * (cos(E) - e) and b * sin(E) along the two
+  // directions, a hyperbola a * (e - cosh(F)) and b * sinh(F)
+  Vector2 axis_a = periapsis_dir * (hyperbola ? -a : a);
+  Vector2 axis_b = normal_dir * b;
+  trajectory_.center = star_pos_ - axis_a * e;
+  trajectory_.u = axis_a * cos_anomaly + axis_b * sin_anomaly;
+  if (hyperbola) {
+    trajectory_.v = (axis_a * sin_anomaly + axis_b * cos_anomaly) * (float)dir;
+  } else {
+    trajectory_.v = (axis_b * cos_anomaly - axis_a * sin_anomaly) * (float)dir;
+  }
+  trajectory_.hyperbola = hyperbola;
+  trajectory_.patterns = patterns;
+  trajectory_.pattern_sizes = pattern_sizes;
+  trajectory_.pattern_count = patterns_count;
+
+  if (!hyperbola) {
+    // Once around, back to the planet
+    trajectory_.end = 2.0f * (float)M_PI;
+  } else {
+    // Until the distance a * (e * cosh(F) - 1) from the star leaves the screen. update()
+    // moves the zoom a step after this, so at the smallest zoom the frame can be drawn at.
+    float smallest_zoom = current_zoom_ - ZOOM_SPEED;
+    float screen_radius = sqrtf(CENTER_X * CENTER_X + CENTER_Y * CENTER_Y) / smallest_zoom + 2.0f;
+    float cosh_end = (screen_radius / a + 1.0f) / e;
+    if (cosh_end <= 1.0f) {
+      return;
     }
+    trajectory_.end = acoshf(cosh_end) - dir * asinhf(sin_anomaly);
+  }
 
-    prev = cur;
+  has_trajectory_ = std::isfinite(trajectory_.u.x) && std::isfinite(trajectory_.u.y) &&
+                    std::isfinite(trajectory_.v.x) && std::isfinite(trajectory_.v.y) &&
+                    std::isfinite(trajectory_.end) && trajectory_.end > 0.0f;
+}
+
+void GameScreen::draw_trajectory() const {
+  if (has_trajectory_) {
+    draw_conic_arc(trajectory_);
   }
 }
 
@@ -386,14 +545,12 @@ void GameScreen::draw_boundaries() const {
   rect.x = CENTER_X - rect.width / 2;
   rect.y = CENTER_Y - rect.height / 2;
 
-  constexpr uint8_t pattern_50_percent = 0xAA;
-  draw_rectangle_lines_pattern(rect, 8, pattern_50_percent);
+  draw_rectangle_lines_pattern(rect, ROW_BOUNDARY_PATTERN_SIZE, ROW_BOUNDARY_PATTERN);
 
   rect.width = DEATH_LENGTH * TILE_W * rect_scale;
   rect.height = DEATH_LENGTH * TILE_H * rect_scale;
   rect.x = CENTER_X - rect.width / 2;
   rect.y = CENTER_Y - rect.height / 2;
 
-  constexpr uint8_t pattern_66_percent = 0xd8;
-  draw_rectangle_lines_pattern(rect, 6, pattern_66_percent);
+  draw_rectangle_lines_pattern(rect, DEATH_BOUNDARY_PATTERN_SIZE, DEATH_BOUNDARY_PATTERN);
 }
@@ -3,6 +3,7 @@
 #include <cstdint>
 
 #include "const.h"
+#include "draw.h"
 #include "game_utils.h"
 #include "orbital.h"
 #include "screen.h"
@@ -22,6 +23,13 @@ public:
 
   virtual void draw() const override;
 
+  /**
+   * @brief Reports the old and new places of the tetraminos and the trajectory, the tiles
+   * that changed, and the score, next tetramino and status text when they changed. The
+   * whole screen while zoomed, during the game over animation and the explosion.
+   */
+  virtual bool get_damage(Rectangle& area) const override;
+
   virtual void close() override;
 
 private:
@@ -40,6 +48,26 @@ private:
   const char* status_text_{};
   bool is_playing_game_over_animation_{};
   int game_over_animation_frame_{};
+  int shake_frame_{};
+  // The orbit ahead of the planet, computed by update() for draw()
+  ConicArc trajectory_{};
+  bool has_trajectory_{};
+
+  // What the previous frame drew, to find the areas that changed since
+  Rectangle drawn_trajectory_rect_{};
+  Rectangle drawn_active_rect_{};
+  Rectangle drawn_sliding_rect_{};
+  Rectangle drawn_status_rect_{};
+  const char* drawn_status_text_{};
+  Tetramino* drawn_next_block_{};
+  int drawn_points_{};
+  float drawn_zoom_{ 1.0f };
+  Rectangle damage_rect_{};
+  bool damage_whole_screen_{ true };
+
+  void start_shake();
+  void update_shake();
+  void stop_shake();
 
   int get_resolution(const PlanetState& planet);
 
@@ -48,6 +76,12 @@ private:
   void update_sliding_tetramino(ActiveTetramino& block);
   void detect_piece_too_far(const ActiveTetramino& block);
 
+  void update_trajectory();
+  void update_damage();
+
+  Rectangle get_trajectory_rect() const;
+  Rectangle get_status_text_rect() const;
+
   void draw_trajectory() const;
   void draw_boundaries() const;
 };
@@ -71,6 +71,21 @@ Rectangle get_collision_rec(const Rectangle& rec1, const Rectangle& rec2) {
   return rec;
 }
 
+Rectangle get_union_rec(const Rectangle& rec1, const Rectangle& rec2) {
+  if (rec1.width <= 0 || rec1.height <= 0) {
+    return rec2;
+  }
+  if (rec2.width <= 0 || rec2.height <= 0) {
+    return rec1;
+  }
+
+  float x = fminf(rec1.x, rec2.x);
+  float y = fminf(rec1.y, rec2.y);
+  float right = fmaxf(rec1.x + rec1.width, rec2.x + rec2.width);
+  float bottom = fmaxf(rec1.y + rec1.height, rec2.y + rec2.height);
+  return { x, y, right - x, bottom - y };
+}
+
 float random_float() {
   return rand() * 1.0f / RAND_MAX;
 }
@@ -45,6 +45,9 @@ bool check_collision_recs(const Rectangle& rec1, const Rectangle& rec2);
 // Get collision rectangle for two rectangles collision
 Rectangle get_collision_rec(const Rectangle& rec1, const Rectangle& rec2);
 
+// Get the smallest rectangle containing both, a rectangle without area counts as none
+Rectangle get_union_rec(const Rectangle& rec1, const Rectangle& rec2);
+
 // Get a random value between min and max (both included)
 int get_random_value(int min, int max);
 
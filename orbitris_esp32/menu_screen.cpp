@@ -50,6 +50,16 @@ Screen* MenuScreen::update() {
 }
 
 void MenuScreen::draw() const {
+  if (is_previous_frame_kept()) {
+    manager_.draw_dirty(LCD_WHITE);
+    return;
+  }
+
   fill_scrfeen_buffer(LCD_WHITE);
   manager_.draw();
 }
+
+bool MenuScreen::get_damage(Rectangle& area) const {
+  area = manager_.get_dirty_rect();
+  return true;
+}
@@ -16,6 +16,8 @@ public:
 
   virtual void draw() const override;
 
+  virtual bool get_damage(Rectangle& area) const override;
+
 private:
 
   Button menu_buttons_[BUTTONS_COUNT];
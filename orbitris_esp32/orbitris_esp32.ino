@@ -3,12 +3,18 @@
 #include "const.h"
 #include "game_main.h"
 #include "input.h"
+#include "screen.h"
 #include "sharp_display.h"
 
 // FPS counter
 static float framesPerSecond = 0.0f;
 static uint64_t frameCount = 0;
 static uint64_t lastMillis = 0;
+static uint64_t bytesSent = 0;
+
+// Bus time a frame gets however long it took to draw, so heavy frames still send
+// something: about a quarter of the lines at 10 MHz
+constexpr uint32_t MIN_TRANSFER_US = FRAME_BUDGET_US / 4;
 
 void setup() {
   Serial.begin(115200);
@@ -18,8 +24,13 @@ void setup() {
   input_init();
 
   lcd_clear();
+#if LCD_STRIP_LINES > 0
+  // Strips are drawn from scratch, so overlays need what they are drawn over
+  set_redraw_underlays(true);
+#else
   lcd_fill_buffer(1);  // Fill buffer with white (1)
   lcd_update();
+#endif
 
   init_game();
 }
@@ -29,9 +40,11 @@ float fps(int seconds) {
   unsigned long currentMillis = millis();
   if ((currentMillis - lastMillis) > (seconds * 1000)) {
     framesPerSecond = ((float)frameCount) / seconds;
+    Serial.printf("%04.3f %u B/frame %u skipped\n", framesPerSecond, (unsigned)(bytesSent / frameCount),
+                  (unsigned)lcd_get_stats().skipped_frames);
     frameCount = 0;
+    bytesSent = 0;
     lastMillis = currentMillis;
-    Serial.printf("%04.3f\n", framesPerSecond);
   }
   return framesPerSecond;
 }
@@ -39,10 +52,20 @@ float fps(int seconds) {
 void loop() {
   uint32_t ts = micros();
   input_update();
+#if LCD_STRIP_LINES > 0
+  update_frame();
+  record_draw_frame();
+  lcd_update_strips(draw_frame);
+#else
   update_draw_frame();
-  // uint32_t dt1 = micros() - ts;
-  // Serial.printf("%u\n", dt1);
+  // The transfer gets what is left of the frame after update and draw, so the frame is on
+  // the panel by the time the next one starts; heavy frames finish over the next ones.
+  // A whole frame's worth of bus time (about 20 KB at 10 MHz) would never hold a line back.
+  uint32_t draw_us = micros() - ts;
+  lcd_set_time_budget(draw_us + MIN_TRANSFER_US < FRAME_BUDGET_US ? FRAME_BUDGET_US - draw_us : MIN_TRANSFER_US);
   lcd_update();
+#endif
+  bytesSent += lcd_get_stats().bytes_sent;
   fps(1);
   uint32_t dt = micros() - ts;
   // Serial.printf("%u\n", dt);
@@ -55,6 +55,12 @@ Screen* PauseScreen::update() {
 }
 
 void PauseScreen::draw() const {
+  if (is_previous_frame_kept()) {
+    // The buttons sit on the white strip
+    manager_.draw_dirty(LCD_WHITE);
+    return;
+  }
+
   draw_rectangle_checkerboard(0, 0, LCD_WIDTH, LCD_HEIGHT);
 
   const int text_x = LCD_WIDTH / 2 - text_size_.x / 2;
@@ -67,3 +73,13 @@ void PauseScreen::draw() const {
 
   manager_.draw();
 }
+
+bool PauseScreen::get_damage(Rectangle& area) const {
+  area = manager_.get_dirty_rect();
+  return true;
+}
+
+const Screen* PauseScreen::underlay() const {
+  // Pause is only entered from the game, and draws over its last frame
+  return screens::game_screen;
+}
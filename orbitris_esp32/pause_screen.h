@@ -15,6 +15,10 @@ public:
 
   virtual void draw() const override;
 
+  virtual bool get_damage(Rectangle& area) const override;
+
+  virtual const Screen* underlay() const override;
+
 private:
   Vector2 text_size_;
   char text_buffer_[100];
@@ -4,8 +4,43 @@ Screen::Screen() {}
 
 void Screen::init() {}
 
+static bool g_redraw_underlays = false;
+static bool g_previous_frame_kept = false;
+
 void Screen::draw() const {}
 
+bool Screen::get_damage(Rectangle& /* area */) const {
+  return false;
+}
+
+const Screen* Screen::underlay() const {
+  return nullptr;
+}
+
+void Screen::draw_with_underlay() const {
+  const Screen* below = underlay();
+  if (g_redraw_underlays && below) {
+    below->draw_with_underlay();
+  }
+  draw();
+}
+
+void set_redraw_underlays(bool redraw) {
+  g_redraw_underlays = redraw;
+}
+
+bool is_redrawing_underlays() {
+  return g_redraw_underlays;
+}
+
+void set_previous_frame_kept(bool kept) {
+  g_previous_frame_kept = kept;
+}
+
+bool is_previous_frame_kept() {
+  return g_previous_frame_kept && !g_redraw_underlays;
+}
+
 void Screen::close() {}
 
 namespace screens {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "game_utils.h"
+
 class Screen {
 public:
   Screen();
@@ -12,9 +14,49 @@ public:
 
   virtual void draw() const;
 
+  /**
+   * @brief Reports the area the last update() changed since the previous frame, so only its
+   * lines are cleared, redrawn and sent when is_previous_frame_kept(). Everything drawn
+   * outside of it must land on the same pixels as in the previous frame.
+   * @return false to have the whole frame redrawn, which is what screens that don't track
+   * their changes do.
+   */
+  virtual bool get_damage(Rectangle& area) const;
+
+  /**
+   * @brief Screen this one is drawn over, for screens that only draw on top of the
+   * previous frame instead of clearing it.
+   */
+  virtual const Screen* underlay() const;
+
+  /**
+   * @brief Draws the underlay first when set_redraw_underlays() is on, then this screen.
+   */
+  void draw_with_underlay() const;
+
   virtual void close();
 };
 
+/**
+ * @brief Makes draw_with_underlay() redraw underlays, for render targets that don't keep
+ * the previous frame (strip rendering). Screens then also draw every frame whole.
+ */
+void set_redraw_underlays(bool redraw);
+
+bool is_redrawing_underlays();
+
+/**
+ * @brief Set by the game loop before drawing a frame: whether the current screen drew the
+ * previous frame on its own, outside of a transition.
+ */
+void set_previous_frame_kept(bool kept);
+
+/**
+ * @brief True if the render target still holds the frame the current screen drew last, so
+ * its draw() only needs to repaint what changed since.
+ */
+bool is_previous_frame_kept();
+
 namespace screens {
 extern Screen* game_screen;
 extern Screen* game_over_screen;
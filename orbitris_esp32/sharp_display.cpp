@@ -1,7 +1,12 @@
 #include "sharp_display.h"
 
-#include <Arduino.h>
-#include <SPI.h>
+#include <algorithm>
+#include <cstring>
+
+#include <driver/gpio.h>
+#include <driver/spi_master.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
 
 #include "const.h"
 
@@ -15,34 +20,293 @@
 // LCD Commands
 #define CMD_UPDATE_MODE 0x80  // Write Command: 1000b + VCOM bit (bit 6)
 #define CMD_ALL_CLEAR 0x20    // All Clear (0010 0000b)
+#define CMD_DISPLAY_MODE 0x00 // Maintain memory, only latches VCOM (bit 6)
 #define CMD_NOP 0x00          // No Operation (Trailer Byte)
 
-#define LINE_PREFIX_LENGTH 2
-// The entire transaction buffer for one line:
-// [1 byte Command] + [1 byte Line Address] + [BYTES_PER_LINE data] + [1 byte Trailer]
-#define LINE_LENGTH (LINE_PREFIX_LENGTH + BYTES_PER_LINE)
-#define UPDATE_COMMAND_SUFFIX_LENGTH 2
+#define LINE_PREFIX_LENGTH 1
+// One line as it follows the command byte on the wire:
+// [1 byte Line Address] + [BYTES_PER_LINE data] + [1 byte Trailer]
+#define LINE_LENGTH (LINE_PREFIX_LENGTH + BYTES_PER_LINE + 1)
+// Runs of lines start on word boundaries, so DMA reads them in place rather than
+// through a bounce buffer
+static_assert(LINE_LENGTH % 4 == 0, "lines in the transaction buffer must stay word aligned");
+
+#if LCD_STRIP_LINES > 0
+// Two strips of [address][data][trailer] lines: one on the bus, one being packed
+#define RASTER_LINES LCD_STRIP_LINES
+#define STRIP_COUNT (LCD_HEIGHT / LCD_STRIP_LINES)
+#define STRIP_TX_SIZE (LINE_LENGTH * LCD_STRIP_LINES)
+#define TX_BUFFER_SIZE (STRIP_TX_SIZE * 2)
+#else
+#define RASTER_LINES LCD_HEIGHT
+#define TX_BUFFER_SIZE (LINE_LENGTH * LCD_HEIGHT)
+#endif
+
+#define DIRTY_WORDS ((LCD_HEIGHT + 31) / 32)
+
+// Command byte, one transaction per run of dirty lines and the final trailer
+#define MAX_TRANSACTIONS (LCD_HEIGHT / 2 + 2)
+
+// Datasheet specifies 2MHz, overclocking to 10MHz
+#define SPI_CLOCK_HZ 10000000
 
 #define TO_BE(x) ((x << 7) | ((x & 0x02) << 5) | ((x & 0x04) << 3) | ((x & 0x08) << 1) | ((x & 0x10) >> 1) | ((x & 0x20) >> 3) | ((x & 0x40) >> 5) | (x >> 7))
 
+#if LCD_STRIP_LINES > 0
+static_assert(LCD_HEIGHT % LCD_STRIP_LINES == 0, "LCD_STRIP_LINES must divide LCD_HEIGHT");
+static_assert(STRIP_COUNT + 2 <= MAX_TRANSACTIONS, "LCD_STRIP_LINES is too small");
+#endif
+
 // Global Variables
-static uint8_t framebuffer[LINE_LENGTH * LCD_HEIGHT + UPDATE_COMMAND_SUFFIX_LENGTH];
+// Draw calls go to the raster: LCD_LINE_WORDS words per line, leftmost pixel of a word in
+// its most significant bit. Changed lines are packed into the transaction buffer on
+// update, and DMA streams that one to the panel while the next frame is drawn.
+// In strip mode the raster only holds lines raster_y0 to raster_y0 + RASTER_LINES - 1.
+static uint32_t framebuffer[LCD_LINE_WORDS * RASTER_LINES];
+static int raster_y0 = 0;
+// Lines clip_y0 to clip_y1 - 1 of the raster take drawing, see lcd_set_clip_lines()
+static DRAW_THREAD_LOCAL int clip_y0 = 0;
+static DRAW_THREAD_LOCAL int clip_y1 = RASTER_LINES;
+// Raster drawing goes to: the framebuffer, or a surface set by lcd_set_target()
+static DRAW_THREAD_LOCAL uint32_t* draw_target = framebuffer;
+alignas(4) static uint8_t tx_buffer[TX_BUFFER_SIZE];
 static int vcom_state = 0;  // 0 or 1 for VCOM polarity
 
-// SPI settings for the Sharp LCD (datasheet specifies 2MHz, overclocking to 10MHz)
-static SPISettings sharpLcdSettings(10000000, MSBFIRST, SPI_MODE0);
+#if LCD_STRIP_LINES == 0
+// One bit per line, set when the line differs from what the panel currently shows
+static uint32_t dirty_lines[DIRTY_WORDS];
+// Frames each dirty line has been waiting for the bus
+static uint8_t line_age[LCD_HEIGHT];
+// Max bytes per update, 0 sends every dirty line
+static uint32_t byte_budget = 0;
+// Hashes of the dirty lines of the frame being submitted
+static uint32_t frame_line_hash[LCD_HEIGHT];
+#endif
+
+// Hash of each line as the panel shows it, valid for the lines in panel_known_lines
+static uint32_t panel_line_hash[LCD_HEIGHT];
+static uint32_t panel_known_lines[DIRTY_WORDS];
+static uint32_t skipped_frames = 0;
+
+// Framebuffer line y goes to panel line y + viewport_dy, its bytes moved right by
+// viewport_dx. Set by lcd_set_viewport(), applied by the next update.
+static int viewport_dy = 0;
+static int viewport_dx = 0;
+static int requested_dy = 0;
+static int requested_dx = 0;
+
+static LcdStats lcd_stats{};
+
+static spi_device_handle_t spi_device;
+static spi_transaction_t transactions[MAX_TRANSACTIONS];
+// Transactions filled in, handed to the driver, and returned by it since the last wait
+static size_t pending_transactions = 0;
+static size_t submitted_transactions = 0;
+static size_t completed_transactions = 0;
 
 
 /**
- * @brief Pre-calculate commands and line numbers for the framebuffer
+ * @brief Pre-calculate commands and line numbers for the transaction buffer
  */
 void framebuffer_init() {
+#if LCD_STRIP_LINES == 0
   for (int y = 0; y < LCD_HEIGHT; y++) {
-    int line_number_idx = (y * LINE_LENGTH) + 1;
-    framebuffer[line_number_idx] = TO_BE(y + 1);
+    tx_buffer[y * LINE_LENGTH] = TO_BE(y + 1);
+    tx_buffer[(y + 1) * LINE_LENGTH - 1] = CMD_NOP;
+  }
+
+  // Panel contents are unknown after power up
+  memset(dirty_lines, 0xff, sizeof(dirty_lines));
+  memset(line_age, 0, sizeof(line_age));
+#endif
+  memset(panel_known_lines, 0, sizeof(panel_known_lines));
+  viewport_dy = requested_dy = 0;
+  viewport_dx = requested_dx = 0;
+}
+
+static inline bool has_line(const uint32_t* lines, int y) {
+  return lines[y >> 5] & (1u << (y & 31));
+}
+
+static inline void mark_line_dirty(int y) {
+#if LCD_STRIP_LINES == 0
+  if (draw_target == framebuffer) {
+    dirty_lines[y >> 5] |= 1u << (y & 31);
   }
+#endif
+}
+
+
+static inline uint32_t rotl32(uint32_t x, int r) {
+  return (x << r) | (x >> (32 - r));
 }
 
+/**
+ * @brief MurmurHash3 over the words of a raster line. Word-wise FNV would be cheaper but
+ * never carries differences in high bits down, so two flipped pixels can cancel out.
+ */
+static uint32_t hash_line(const uint32_t* line) {
+  uint32_t hash = 0;
+  for (int i = 0; i < LCD_LINE_WORDS; i++) {
+    uint32_t k = line[i] * 0xcc9e2d51u;
+    k = rotl32(k, 15) * 0x1b873593u;
+    hash = rotl32(hash ^ k, 13) * 5 + 0xe6546b64u;
+  }
+
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+#if LCD_STRIP_LINES == 0
+static inline bool is_line_dirty(int y) {
+  return has_line(dirty_lines, y);
+}
+
+/**
+ * @brief Clears the dirty bit of lines that were redrawn to what the panel already shows,
+ * e.g. on screens that clear and redraw the same picture every frame.
+ */
+static void drop_unchanged_lines() {
+  for (int y = 0; y < LCD_HEIGHT; y++) {
+    if (!is_line_dirty(y)) {
+      continue;
+    }
+
+    // Lines moved off the panel by the viewport are not sent at all
+    int panel_y = y + viewport_dy;
+    if (panel_y < 0 || panel_y >= LCD_HEIGHT) {
+      dirty_lines[y >> 5] &= ~(1u << (y & 31));
+      line_age[y] = 0;
+      continue;
+    }
+
+    frame_line_hash[y] = hash_line(&framebuffer[y * LCD_LINE_WORDS]);
+    if (has_line(panel_known_lines, panel_y) && panel_line_hash[panel_y] == frame_line_hash[y]) {
+      dirty_lines[y >> 5] &= ~(1u << (y & 31));
+      line_age[y] = 0;
+    }
+  }
+}
+
+/**
+ * @brief Picks the dirty lines that fit into the byte budget, the ones that waited the
+ * longest first. Lines of the same age go top to bottom.
+ * @param[out] send_lines Line bitmap of DIRTY_WORDS words.
+ */
+static void select_lines_to_send(uint32_t* send_lines) {
+  memcpy(send_lines, dirty_lines, sizeof(dirty_lines));
+  if (byte_budget == 0) {
+    return;
+  }
+
+  // Command byte and final trailer go out with every update, and at least one line
+  // is sent so the panel always converges
+  int max_lines = byte_budget > 2 ? (byte_budget - 2) / LINE_LENGTH : 0;
+  if (max_lines < 1) {
+    max_lines = 1;
+  }
+
+  int dirty_count = 0;
+  uint16_t age_histogram[UINT8_MAX + 1]{};
+  for (int y = 0; y < LCD_HEIGHT; y++) {
+    if (is_line_dirty(y)) {
+      dirty_count++;
+      age_histogram[line_age[y]]++;
+    }
+  }
+
+  if (dirty_count <= max_lines) {
+    return;
+  }
+
+  // Lines older than the threshold all fit, lines of the threshold age fill up the rest
+  int threshold = UINT8_MAX;
+  int taken = 0;
+  while (taken + age_histogram[threshold] <= max_lines) {
+    taken += age_histogram[threshold];
+    threshold--;
+  }
+
+  int remaining = max_lines - taken;
+  memset(send_lines, 0, sizeof(dirty_lines));
+  for (int y = 0; y < LCD_HEIGHT; y++) {
+    if (!is_line_dirty(y)) {
+      continue;
+    }
+
+    if (line_age[y] > threshold || (line_age[y] == threshold && remaining-- > 0)) {
+      send_lines[y >> 5] |= 1u << (y & 31);
+    }
+  }
+}
+
+#endif
+
+/**
+ * @brief Packs a raster line into BYTES_PER_LINE bytes in panel order. Words are stored
+ * little-endian, so their bytes are swapped to go out leftmost pixel first.
+ */
+static void pack_raster_line(const uint32_t* line, uint8_t* out) {
+  int x = 0;
+  for (; x + 4 <= BYTES_PER_LINE; x += 4) {
+    uint32_t wire_word = __builtin_bswap32(line[x >> 2]);
+    memcpy(&out[x], &wire_word, sizeof(wire_word));
+  }
+
+  for (; x < BYTES_PER_LINE; x++) {
+    out[x] = line[x >> 2] >> (24 - (x & 3) * 8);
+  }
+}
+
+/**
+ * @brief Moves the bytes of a packed line right by viewport_dx (left if negative),
+ * filling the uncovered bytes with white.
+ */
+static void shift_packed_line(uint8_t* out) {
+  if (viewport_dx > 0) {
+    memmove(&out[viewport_dx], out, BYTES_PER_LINE - viewport_dx);
+    memset(out, 0xff, viewport_dx);
+  } else if (viewport_dx < 0) {
+    memmove(out, &out[-viewport_dx], BYTES_PER_LINE + viewport_dx);
+    memset(&out[BYTES_PER_LINE + viewport_dx], 0xff, -viewport_dx);
+  }
+}
+
+/**
+ * @brief Applies the viewport requested by lcd_set_viewport(). Lines that land on other
+ * panel lines are compared against those by hash and resent if they differ, and every
+ * line is resent after a horizontal move. Nothing is redrawn.
+ * @return true if the viewport changed
+ */
+static bool apply_viewport() {
+  if (requested_dy == viewport_dy && requested_dx == viewport_dx) {
+    return false;
+  }
+
+  if (requested_dx != viewport_dx) {
+    // Panel hashes are of unshifted lines
+    memset(panel_known_lines, 0, sizeof(panel_known_lines));
+  }
+  viewport_dy = requested_dy;
+  viewport_dx = requested_dx;
+  return true;
+}
+
+#if LCD_STRIP_LINES == 0
+/**
+ * @brief Copies a raster line into its slot of the transaction buffer.
+ */
+static void pack_line(int y) {
+  uint8_t* out = &tx_buffer[(y * LINE_LENGTH) + LINE_PREFIX_LENGTH];
+  pack_raster_line(&framebuffer[y * LCD_LINE_WORDS], out);
+  shift_packed_line(out);
+}
+#endif
+
 /**
  * @brief Toggles the VCOM hardware pin and updates the VCOM state for the next command.
  */
@@ -51,92 +315,576 @@ void lcd_toggle_vcom() {
 }
 
 /**
- * @brief Transfers data via SPI using the Arduino SPI library.
+ * @brief Releases CS once the last transaction of an update is on the wire.
+ * Runs in the SPI interrupt.
+ */
+static void IRAM_ATTR spi_post_transfer(spi_transaction_t* transaction) {
+  if (transaction->user != nullptr) {
+    gpio_set_level((gpio_num_t)PIN_NUM_CS, 0);
+  }
+}
+
+/**
+ * @brief Queues a DMA transaction. The buffer must stay untouched until spi_wait_transfer().
  * @param buffer The data buffer to send.
  * @param len The length of the buffer in bytes.
  */
-void spi_transfer_bytes(const uint8_t* buffer, size_t len) {
-  SPI.beginTransaction(sharpLcdSettings);
-  digitalWrite(PIN_NUM_CS, HIGH);
+static void spi_queue_bytes(const uint8_t* buffer, size_t len) {
+  spi_transaction_t& transaction = transactions[pending_transactions++];
+  transaction = {};
+  transaction.length = len * 8;
+  transaction.tx_buffer = buffer;
+  lcd_stats.bytes_sent += len;
+}
+
+/**
+ * @brief Queues a short command that is copied into the transaction itself.
+ */
+static void spi_queue_command(uint8_t command, uint8_t trailer, size_t len) {
+  spi_transaction_t& transaction = transactions[pending_transactions++];
+  transaction = {};
+  transaction.flags = SPI_TRANS_USE_TXDATA;
+  transaction.length = len * 8;
+  transaction.tx_data[0] = command;
+  transaction.tx_data[1] = trailer;
+  lcd_stats.bytes_sent += len;
+}
+
+/**
+ * @brief Hands the transactions queued since the last call to the SPI driver.
+ */
+static void spi_submit_transactions() {
+  for (; submitted_transactions < pending_transactions; submitted_transactions++) {
+    spi_device_queue_trans(spi_device, &transactions[submitted_transactions], portMAX_DELAY);
+  }
+}
 
-  SPI.transferBytes((uint8_t*)buffer, nullptr, len);
+/**
+ * @brief Raises CS and hands all queued transactions to the SPI driver. Returns immediately.
+ */
+static void spi_start_transfer() {
+  // Last transaction drops CS from the interrupt
+  transactions[pending_transactions - 1].user = (void*)1;
+
+  gpio_set_level((gpio_num_t)PIN_NUM_CS, 1);
+  spi_submit_transactions();
+}
+
+/**
+ * @brief Blocks until the given transaction, and every one before it, has been sent.
+ */
+static void spi_wait_transaction(size_t index) {
+  spi_transaction_t* done;
+  for (; completed_transactions <= index; completed_transactions++) {
+    spi_device_get_trans_result(spi_device, &done, portMAX_DELAY);
+  }
+}
 
-  digitalWrite(PIN_NUM_CS, LOW);
-  SPI.endTransaction();
+/**
+ * @brief Blocks until every queued transaction has been sent.
+ */
+static void spi_wait_transfer() {
+  if (submitted_transactions > 0) {
+    spi_wait_transaction(submitted_transactions - 1);
+  }
+  pending_transactions = 0;
+  submitted_transactions = 0;
+  completed_transactions = 0;
 }
 
 void lcd_init() {
-  pinMode(PIN_NUM_CS, OUTPUT);
+  gpio_reset_pin((gpio_num_t)PIN_NUM_CS);
+  gpio_set_direction((gpio_num_t)PIN_NUM_CS, GPIO_MODE_OUTPUT);
+  gpio_set_level((gpio_num_t)PIN_NUM_CS, 0);  // CS Low (Inactive)
 
-  // Initialize SPI bus (CLK, MOSI). MISO and SS are set to -1 as they are not used.
-  SPI.begin(PIN_NUM_CLK, -1, PIN_NUM_MOSI, -1);
+  // Initialize SPI bus (CLK, MOSI) with DMA, so a whole frame goes out without the CPU
+  spi_bus_config_t bus_config{};
+  bus_config.mosi_io_num = PIN_NUM_MOSI;
+  bus_config.miso_io_num = -1;
+  bus_config.sclk_io_num = PIN_NUM_CLK;
+  bus_config.quadwp_io_num = -1;
+  bus_config.quadhd_io_num = -1;
+  bus_config.max_transfer_sz = TX_BUFFER_SIZE;
+  spi_bus_initialize(SPI2_HOST, &bus_config, SPI_DMA_CH_AUTO);
+
+  // CS is active high on this panel, so it is driven manually
+  spi_device_interface_config_t device_config{};
+  device_config.mode = 0;
+  device_config.clock_speed_hz = SPI_CLOCK_HZ;
+  device_config.spics_io_num = -1;
+  device_config.queue_size = MAX_TRANSACTIONS;
+  device_config.post_cb = spi_post_transfer;
+  spi_bus_add_device(SPI2_HOST, &device_config, &spi_device);
 
-  // Set initial states
-  digitalWrite(PIN_NUM_CS, LOW);  // CS Low (Inactive)
   vcom_state = 0;
+  pending_transactions = 0;
+  submitted_transactions = 0;
+  completed_transactions = 0;
 
   framebuffer_init();
 }
 
+void lcd_deinit() {
+  spi_wait_transfer();
+  spi_bus_remove_device(spi_device);
+  spi_bus_free(SPI2_HOST);
+}
+
+#if LCD_STRIP_LINES == 0
 void lcd_update() {
-  // 1. Send framebuffer data
-  framebuffer[0] = CMD_UPDATE_MODE | (vcom_state << 6);
-  spi_transfer_bytes(framebuffer, sizeof(framebuffer));
+  // The previous frame must be off the wire before the transaction buffer is reused
+  spi_wait_transfer();
+  lcd_stats = {};
+
+  // The transaction buffer is free now, so line addresses can be rewritten
+  if (apply_viewport()) {
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+      int panel_y = y + viewport_dy;
+      if (panel_y >= 0 && panel_y < LCD_HEIGHT) {
+        tx_buffer[y * LINE_LENGTH] = TO_BE(panel_y + 1);
+      }
+    }
+    memset(dirty_lines, 0xff, sizeof(dirty_lines));
+  }
+
+  drop_unchanged_lines();
+
+  uint32_t send_lines[DIRTY_WORDS];
+  select_lines_to_send(send_lines);
+  bool has_dirty_lines = false;
+
+  for (int y = 0; y < LCD_HEIGHT;) {
+    if (!has_line(send_lines, y)) {
+      y++;
+      continue;
+    }
+
+    if (!has_dirty_lines) {
+      // 1. Command byte goes out once for all addressed lines
+      spi_queue_command(CMD_UPDATE_MODE | (vcom_state << 6), CMD_NOP, 1);
+      has_dirty_lines = true;
+    }
+
+    // 2. Send the whole run of consecutive selected lines. Every line goes out as
+    // [address][data][trailer] straight from the transaction buffer.
+    int run_start = y;
+    while (y < LCD_HEIGHT && has_line(send_lines, y)) {
+      pack_line(y);
+      y++;
+    }
+
+    spi_queue_bytes(&tx_buffer[run_start * LINE_LENGTH], (y - run_start) * LINE_LENGTH);
+    lcd_stats.lines_sent += y - run_start;
+  }
+
+  if (has_dirty_lines) {
+    // 3. Final trailer of the multi-line update
+    spi_queue_command(CMD_NOP, CMD_NOP, 1);
+  } else {
+    // 3. Nothing changed, a bare display mode command keeps VCOM alternating
+    spi_queue_command(CMD_DISPLAY_MODE | (vcom_state << 6), CMD_NOP, 2);
+    skipped_frames++;
+  }
+  lcd_stats.skipped_frames = skipped_frames;
 
-  // 2. Toggle VCOM polarity for the next frame
+  spi_start_transfer();
+
+  // 4. Lines left out by the budget stay dirty and get older
+  for (int y = 0; y < LCD_HEIGHT; y++) {
+    if (has_line(send_lines, y)) {
+      int panel_y = y + viewport_dy;
+      line_age[y] = 0;
+      panel_line_hash[panel_y] = frame_line_hash[y];
+      panel_known_lines[panel_y >> 5] |= 1u << (panel_y & 31);
+    } else if (is_line_dirty(y)) {
+      if (line_age[y] < UINT8_MAX) {
+        line_age[y]++;
+      }
+      lcd_stats.deferred_lines++;
+      if (line_age[y] > lcd_stats.max_deferred_age) {
+        lcd_stats.max_deferred_age = line_age[y];
+      }
+    }
+  }
+
+  for (int i = 0; i < DIRTY_WORDS; i++) {
+    dirty_lines[i] &= ~send_lines[i];
+  }
+
+  // 5. Toggle VCOM polarity for the next frame
   lcd_toggle_vcom();
 }
+#else
+/**
+ * @brief Packs the lines of the drawn strip that differ from the panel into a strip
+ * slot of the transaction buffer, each as [address][data][trailer].
+ * @return number of lines packed
+ */
+static int pack_strip(uint8_t* slot) {
+  int packed = 0;
+  for (int i = 0; i < LCD_STRIP_LINES; i++) {
+    int panel_y = raster_y0 + i + viewport_dy;
+    if (panel_y < 0 || panel_y >= LCD_HEIGHT) {
+      continue;
+    }
 
-void lcd_clear() {
-  uint8_t command[2];
+    const uint32_t* line = &framebuffer[i * LCD_LINE_WORDS];
+    uint32_t hash = hash_line(line);
+    if (has_line(panel_known_lines, panel_y) && panel_line_hash[panel_y] == hash) {
+      continue;
+    }
+
+    uint8_t* out = &slot[packed * LINE_LENGTH];
+    out[0] = TO_BE(panel_y + 1);
+    pack_raster_line(line, &out[LINE_PREFIX_LENGTH]);
+    shift_packed_line(&out[LINE_PREFIX_LENGTH]);
+    out[LINE_LENGTH - 1] = CMD_NOP;
+    packed++;
+
+    panel_line_hash[panel_y] = hash;
+    panel_known_lines[panel_y >> 5] |= 1u << (panel_y & 31);
+  }
+  return packed;
+}
 
-  // Command Byte: CMD_ALL_CLEAR (0x20) | VCOM state (bit 6)
-  command[0] = CMD_ALL_CLEAR | (vcom_state << 6);
+void lcd_update_strips(void (*draw)()) {
+  spi_wait_transfer();
+  lcd_stats = {};
+  apply_viewport();
 
-  // Trailer Byte (NOP)
-  command[1] = CMD_NOP;
+  // 1. Command byte goes out right away, the lines follow strip by strip under one CS
+  spi_queue_command(CMD_UPDATE_MODE | (vcom_state << 6), CMD_NOP, 1);
+  gpio_set_level((gpio_num_t)PIN_NUM_CS, 1);
+  spi_submit_transactions();
 
-  spi_transfer_bytes(command, 2);
+  // Transaction that last used each slot, 0 (the command) if none
+  size_t slot_transaction[2] = {};
+  for (int strip = 0; strip < STRIP_COUNT; strip++) {
+    // 2. Draw the strip while DMA sends the previous one
+    raster_y0 = strip * LCD_STRIP_LINES;
+    clip_y0 = raster_y0;
+    clip_y1 = raster_y0 + RASTER_LINES;
+    draw();
+
+    // 3. The slot was last handed to DMA two strips ago
+    uint8_t* slot = &tx_buffer[(strip & 1) * STRIP_TX_SIZE];
+    spi_wait_transaction(slot_transaction[strip & 1]);
+
+    int packed = pack_strip(slot);
+    if (packed > 0) {
+      slot_transaction[strip & 1] = pending_transactions;
+      spi_queue_bytes(slot, packed * LINE_LENGTH);
+      spi_submit_transactions();
+      lcd_stats.lines_sent += packed;
+    }
+  }
+
+  // 4. Final trailer drops CS. With no lines sent, the update only refreshed VCOM.
+  spi_queue_command(CMD_NOP, CMD_NOP, 1);
+  transactions[pending_transactions - 1].user = (void*)1;
+  spi_submit_transactions();
+
+  if (lcd_stats.lines_sent == 0) {
+    skipped_frames++;
+  }
+  lcd_stats.skipped_frames = skipped_frames;
+
+  // 5. Toggle VCOM polarity for the next frame
+  lcd_toggle_vcom();
+}
+#endif
+
+void lcd_set_byte_budget(uint32_t bytes) {
+#if LCD_STRIP_LINES == 0
+  byte_budget = bytes;
+#endif
+}
+
+void lcd_set_time_budget(uint32_t budget_us) {
+  lcd_set_byte_budget((uint64_t)budget_us * SPI_CLOCK_HZ / 8 / 1000000);
+}
+
+void lcd_set_viewport(int dy, int dx_bytes) {
+  requested_dy = dy;
+  requested_dx = dx_bytes < -BYTES_PER_LINE ? -BYTES_PER_LINE : (dx_bytes > BYTES_PER_LINE ? BYTES_PER_LINE : dx_bytes);
+}
+
+void lcd_get_viewport(int* dy, int* dx_bytes) {
+  *dy = viewport_dy;
+  *dx_bytes = viewport_dx;
+}
+
+void lcd_wait_update() {
+  spi_wait_transfer();
+}
+
+const LcdStats& lcd_get_stats() {
+  return lcd_stats;
+}
+
+void lcd_clear() {
+  spi_wait_transfer();
+
+  // Command Byte: CMD_ALL_CLEAR (0x20) | VCOM state (bit 6), Trailer Byte (NOP)
+  spi_queue_command(CMD_ALL_CLEAR | (vcom_state << 6), CMD_NOP, 2);
+  spi_start_transfer();
+  spi_wait_transfer();
+
+  // Panel memory no longer matches the framebuffer
+#if LCD_STRIP_LINES == 0
+  memset(dirty_lines, 0xff, sizeof(dirty_lines));
+#endif
+  memset(panel_known_lines, 0, sizeof(panel_known_lines));
 
   // After All Clear, the VCOM polarity should be toggled for the next frame
   lcd_toggle_vcom();
 }
 
+#if LCD_STRIP_LINES == 0
+void lcd_read_line(int y, uint8_t* out) {
+  pack_raster_line(&framebuffer[y * LCD_LINE_WORDS], out);
+}
+#endif
+
 void lcd_fill_buffer(int color) {
   // Sharp LCD logic: 0 = White (Clear), 1 = Black (Set)
-  uint8_t value = (color == 1) ? 0xFF : 0x00;
-  for (int y = 0; y < LCD_HEIGHT; y++) {
-    int byte_index = (y * LINE_LENGTH) + LINE_PREFIX_LENGTH;
-    memset(&framebuffer[byte_index], value, BYTES_PER_LINE);
+  uint32_t value = (color == 1) ? ~0u : 0u;
+  for (int i = clip_y0 - raster_y0; i < clip_y1 - raster_y0; i++) {
+    uint32_t* line = &draw_target[i * LCD_LINE_WORDS];
+    uint32_t changed = 0;
+    for (int x = 0; x < LCD_LINE_WORDS - 1; x++) {
+      changed |= line[x] ^ value;
+      line[x] = value;
+    }
+    changed |= line[LCD_LINE_WORDS - 1] ^ (value & LCD_LAST_WORD_MASK);
+    line[LCD_LINE_WORDS - 1] = value & LCD_LAST_WORD_MASK;
+
+    if (changed) {
+      mark_line_dirty(raster_y0 + i);
+    }
   }
 }
 
 void lcd_fill_line(int line, uint8_t pattern, int color) {
-  int byte_index = (line * LINE_LENGTH) + LINE_PREFIX_LENGTH;
-  if (color == 1) {  // white
-    for (int x = 0; x < BYTES_PER_LINE; x++) {
-      framebuffer[byte_index + x] |= pattern;
+  if (line < clip_y0 || line >= clip_y1) return;
+
+  uint32_t* words = &draw_target[(line - raster_y0) * LCD_LINE_WORDS];
+  uint32_t mask = pattern * 0x01010101u;
+  uint32_t changed = 0;
+  for (int x = 0; x < LCD_LINE_WORDS; x++) {
+    uint32_t word_mask = (x == LCD_LINE_WORDS - 1) ? mask & LCD_LAST_WORD_MASK : mask;
+    if (color == 1) {  // white
+      changed |= ~words[x] & word_mask;
+      words[x] |= word_mask;
+    } else {
+      changed |= words[x] & word_mask;
+      words[x] &= ~word_mask;
     }
+  }
+
+  if (changed) {
+    mark_line_dirty(line);
+  }
+}
+
+static inline void fill_word(uint32_t& word, uint32_t mask, int color, uint32_t& changed) {
+  if (color == 1) {
+    changed |= ~word & mask;
+    word |= mask;
   } else {
-    for (int x = 0; x < BYTES_PER_LINE; x++) {
-      framebuffer[byte_index + x] &= ~pattern;
+    changed |= word & mask;
+    word &= ~mask;
+  }
+}
+
+void lcd_fill_span(int y, int x0, int x1, int color) {
+  lcd_fill_span_pattern(y, x0, x1, 0xff, color);
+}
+
+void lcd_fill_span_pattern(int y, int x0, int x1, uint8_t pattern, int color) {
+  if (y < clip_y0 || y >= clip_y1) return;
+  x0 = std::max(x0, 0);
+  x1 = std::min(x1, LCD_WIDTH);
+  if (x0 >= x1) return;
+
+  uint32_t* words = &draw_target[(y - raster_y0) * LCD_LINE_WORDS];
+  uint32_t mask = pattern * 0x01010101u;
+  int first = x0 >> 5;
+  int last = (x1 - 1) >> 5;
+  // Left-to-right is MSB (31) to LSB (0)
+  uint32_t first_mask = ~0u >> (x0 & 31);
+  uint32_t last_mask = ~0u << (31 - ((x1 - 1) & 31));
+
+  uint32_t changed = 0;
+  if (first == last) {
+    fill_word(words[first], mask & first_mask & last_mask, color, changed);
+  } else {
+    fill_word(words[first], mask & first_mask, color, changed);
+    for (int x = first + 1; x < last; x++) {
+      fill_word(words[x], mask, color, changed);
+    }
+    fill_word(words[last], mask & last_mask, color, changed);
+  }
+
+  if (changed) {
+    mark_line_dirty(y);
+  }
+}
+
+static inline void write_word(uint32_t& word, uint32_t set, uint32_t clear, uint32_t toggle, uint32_t& changed) {
+  uint32_t old_value = word;
+  word = ((word & ~clear) | set) ^ toggle;
+  changed |= word ^ old_value;
+}
+
+void lcd_write_bits(int y, int x, uint32_t set, uint32_t clear, uint32_t toggle) {
+  if (y < clip_y0 || y >= clip_y1 || x <= -32 || x >= LCD_WIDTH) return;
+
+  uint32_t* words = &draw_target[(y - raster_y0) * LCD_LINE_WORDS];
+  int word = (x + 32) / 32 - 1;  // rounds down for negative x
+  int shift = x & 31;
+  uint32_t changed = 0;
+  if (word >= 0) {
+    uint32_t mask = word == LCD_LINE_WORDS - 1 ? LCD_LAST_WORD_MASK : ~0u;
+    write_word(words[word], (set >> shift) & mask, (clear >> shift) & mask, (toggle >> shift) & mask, changed);
+  }
+  if (shift != 0 && word + 1 < LCD_LINE_WORDS) {
+    uint32_t mask = word + 1 == LCD_LINE_WORDS - 1 ? LCD_LAST_WORD_MASK : ~0u;
+    int back = 32 - shift;
+    write_word(words[word + 1], (set << back) & mask, (clear << back) & mask, (toggle << back) & mask, changed);
+  }
+
+  if (changed) {
+    mark_line_dirty(y);
+  }
+}
+
+/**
+ * @brief Returns 0 or ~0u if pixels first to last of a raster line are all clear or all
+ * set, 1 if they differ.
+ */
+static uint32_t raster_run_value(const uint32_t* line, int first, int last) {
+  uint32_t set = ~0u;
+  uint32_t clear = ~0u;
+  for (int word = first >> 5; word <= last >> 5; word++) {
+    uint32_t mask = ~0u;
+    if (word == first >> 5) mask &= ~0u >> (first & 31);
+    if (word == last >> 5) mask &= ~0u << (31 - (last & 31));
+    set &= (line[word] & mask) == mask ? ~0u : 0;
+    clear &= (line[word] & mask) == 0 ? ~0u : 0;
+  }
+  return set ? ~0u : clear ? 0 : 1;
+}
+
+/**
+ * @brief Builds a raster line from the pixels of a source line at the given columns.
+ * Screens are mostly blank, so words sampling a run of equal pixels are filled at once.
+ */
+static void scale_raster_line(const uint32_t* source, const int16_t* columns, uint32_t* out) {
+  for (int word = 0; word < LCD_LINE_WORDS; word++) {
+    int end = std::min(32, LCD_WIDTH - word * 32);
+    const int16_t* word_columns = &columns[word * 32];
+    uint32_t value = raster_run_value(source, word_columns[0], word_columns[end - 1]);
+    if (value == 1) {
+      value = 0;
+      for (int bit = 0; bit < end; bit++) {
+        int x = word_columns[bit];
+        value |= ((source[x >> 5] << (x & 31)) & 0x80000000u) >> bit;
+      }
+    }
+    out[word] = word == LCD_LINE_WORDS - 1 ? value & LCD_LAST_WORD_MASK : value;
+  }
+}
+
+int lcd_raster_words() {
+  return LCD_LINE_WORDS * RASTER_LINES;
+}
+
+void lcd_set_target(uint32_t* raster) {
+  draw_target = raster ? raster : framebuffer;
+}
+
+void lcd_copy_raster(const uint32_t* source, const uint8_t* mask) {
+  for (int i = clip_y0 - raster_y0; i < clip_y1 - raster_y0; i++) {
+    uint32_t* line = &draw_target[i * LCD_LINE_WORDS];
+    const uint32_t* from = &source[i * LCD_LINE_WORDS];
+    uint32_t pattern = mask[(raster_y0 + i) & 7] * 0x01010101u;
+    if (pattern == 0) {
+      continue;
+    }
+
+    uint32_t changed = 0;
+    for (int x = 0; x < LCD_LINE_WORDS; x++) {
+      uint32_t value = (line[x] & ~pattern) | (from[x] & pattern);
+      changed |= line[x] ^ value;
+      line[x] = value;
+    }
+
+    if (changed) {
+      mark_line_dirty(raster_y0 + i);
+    }
+  }
+}
+
+void lcd_copy_raster_scaled(const uint32_t* source, const int16_t* source_rows, const int16_t* source_columns,
+                            const uint8_t* mask) {
+  // Consecutive lines often sample the same source line, which is then scaled once
+  uint32_t scaled[LCD_LINE_WORDS];
+  int scaled_row = -1;
+  for (int i = clip_y0 - raster_y0; i < clip_y1 - raster_y0; i++) {
+    uint32_t pattern = mask[(raster_y0 + i) & 7] * 0x01010101u;
+    int row = source_rows[raster_y0 + i] - raster_y0;
+    if (pattern == 0 || row < 0 || row >= RASTER_LINES) {
+      continue;
+    }
+
+    if (row != scaled_row) {
+      scale_raster_line(&source[row * LCD_LINE_WORDS], source_columns, scaled);
+      scaled_row = row;
+    }
+
+    uint32_t* line = &draw_target[i * LCD_LINE_WORDS];
+    uint32_t changed = 0;
+    for (int x = 0; x < LCD_LINE_WORDS; x++) {
+      uint32_t value = (line[x] & ~pattern) | (scaled[x] & pattern);
+      changed |= line[x] ^ value;
+      line[x] = value;
+    }
+
+    if (changed) {
+      mark_line_dirty(raster_y0 + i);
     }
   }
 }
 
+void lcd_set_clip_lines(int first, int count) {
+  clip_y0 = std::max(first, raster_y0);
+  clip_y1 = std::max(clip_y0, std::min(first + count, raster_y0 + RASTER_LINES));
+}
+
+void lcd_get_raster_lines(int* first, int* count) {
+  *first = clip_y0;
+  *count = clip_y1 - clip_y0;
+}
+
 void lcd_draw_pixel(int x, int y, int color) {
-  if (x < 0 || x >= LCD_WIDTH || y < 0 || y >= LCD_HEIGHT) return;
+  if (x < 0 || x >= LCD_WIDTH || y < clip_y0 || y >= clip_y1) return;
 
-  // Calculate byte index and bit position
-  int byte_index = (y * LINE_LENGTH) + LINE_PREFIX_LENGTH + (x >> 3);
-  // Display is big-endian, so left-to-right is MSB (7) to LSB (0)
-  uint8_t bit_pos = 7 - (x & 7);
+  // Calculate word index and bit position
+  int word_index = ((y - raster_y0) * LCD_LINE_WORDS) + (x >> 5);
+  // Left-to-right is MSB (31) to LSB (0)
+  uint32_t bit = 0x80000000u >> (x & 31);
 
+  uint32_t old_value = draw_target[word_index];
   if (color == 1) {
     // Set bit (Black/Pixel On)
-    framebuffer[byte_index] |= (1 << bit_pos);
+    draw_target[word_index] |= bit;
   } else {
     // Clear bit (White/Pixel Off)
-    framebuffer[byte_index] &= ~(1 << bit_pos);
+    draw_target[word_index] &= ~bit;
+  }
+
+  if (draw_target[word_index] != old_value) {
+    mark_line_dirty(y);
   }
 }
@@ -4,18 +4,147 @@
 
 #include <cstdint>
 
+#include "const.h"
+
+// Strip rendering: with LCD_STRIP_LINES > 0 there is no full-frame buffer. Frames are
+// drawn LCD_STRIP_LINES lines at a time by lcd_update_strips(), which saves about 22 KB
+// of DRAM (framebuffer and transaction buffer) at the cost of replaying the draw calls
+// once per strip. Must divide LCD_HEIGHT.
+#ifndef LCD_STRIP_LINES
+#define LCD_STRIP_LINES 0
+#endif
+
+// Framebuffer raster layout: each line is LCD_LINE_WORDS 32-bit words, the leftmost
+// pixel of a word in its most significant bit
+constexpr int LCD_LINE_WORDS = (LCD_WIDTH + 31) / 32;
+
+// Bits of the last word of a raster line that hold pixels
+constexpr uint32_t LCD_LAST_WORD_MASK = ~0u << (LCD_LINE_WORDS * 32 - LCD_WIDTH);
+
+/**
+ * @brief Transfer counters of the last lcd_update() call.
+ */
+struct LcdStats {
+  uint32_t bytes_sent;  // bytes clocked out over SPI, command and trailers included
+  uint16_t lines_sent;  // lines addressed in the update command
+  uint16_t deferred_lines;  // changed lines left for later updates by the budget
+  uint8_t max_deferred_age;  // frames the oldest deferred line has been waiting
+  uint32_t skipped_frames;  // updates since lcd_init() that only refreshed VCOM
+};
+
 void lcd_init();
 
 /**
- * @brief Sends framebuffer data to the display
+ * @brief Waits for the last update to leave the bus, then releases the SPI device and bus.
+ */
+void lcd_deinit();
+
+#if LCD_STRIP_LINES == 0
+/**
+ * @brief Starts sending the lines changed since the previous update to the display in
+ * a single multi-line update command. Lines redrawn to the same pixels are detected by
+ * hash and skipped, and only VCOM is refreshed if nothing changed.
+ *
+ * Changed lines are packed from the framebuffer into a separate transaction buffer that
+ * DMA streams while the next frame is drawn, so the call only waits for the previous
+ * frame to leave the bus.
  */
 void lcd_update();
+#else
+/**
+ * @brief Draws and sends a frame strip by strip. The draw callback is called once per
+ * strip with drawing clipped to the strip, so it must draw the whole frame every time
+ * and must not change any state. Each strip's changed lines are streamed to the panel
+ * while the next strip is drawn. Replaces lcd_update() in strip mode.
+ */
+void lcd_update_strips(void (*draw)());
+#endif
+
+/**
+ * @brief Limits the bytes sent by each lcd_update(). Changed lines that don't fit
+ * are deferred to later updates, the ones waiting the longest go first.
+ * @param bytes Budget per update, 0 sends every changed line.
+ *
+ * Strip mode has nowhere to keep deferred lines, so it always sends every changed line.
+ */
+void lcd_set_byte_budget(uint32_t bytes);
+
+/**
+ * @brief Same as lcd_set_byte_budget(), with the budget given as time on the bus.
+ * @param budget_us Budget per update in microseconds, 0 sends every changed line.
+ */
+void lcd_set_time_budget(uint32_t budget_us);
+
+/**
+ * @brief Moves the picture on the panel without redrawing it. From the next update, line
+ * y of the framebuffer is sent to panel line y + dy, and byte x of each line to byte
+ * x + dx_bytes. Lines moved off the panel are not sent, panel lines nothing lands on
+ * keep what they show, and bytes moved in from the side are white. Used for screen
+ * shake and slide transitions; costs bus time for the lines that change, no drawing.
+ */
+void lcd_set_viewport(int dy, int dx_bytes);
+
+/**
+ * @brief Returns the viewport the last update was sent with.
+ */
+void lcd_get_viewport(int* dy, int* dx_bytes);
+
+/**
+ * @brief Blocks until the frame submitted by the last lcd_update() is on the panel.
+ */
+void lcd_wait_update();
+
+/**
+ * @brief Returns transfer counters of the last lcd_update() call.
+ */
+const LcdStats& lcd_get_stats();
 
 /**
  * @brief Sends an All Clear command to the display.
  */
 void lcd_clear();
 
+/**
+ * @brief Returns the size in words of the raster drawing goes to: LCD_LINE_WORDS per line,
+ * for all lines or one strip. Surfaces for lcd_set_target() need as many.
+ */
+int lcd_raster_words();
+
+/**
+ * @brief Sends drawing from the calling thread to another raster with the framebuffer's
+ * layout and lines, nullptr for the framebuffer. Nothing drawn there reaches the panel.
+ */
+void lcd_set_target(uint32_t* raster);
+
+/**
+ * @brief Copies pixels of a raster given to lcd_set_target() into the current target where
+ * mask is set, whole words at a time, over the lines drawing lands in.
+ * @param mask 8 rows of 8 pixels repeating over the screen, leftmost pixel in the most
+ * significant bit, like DrawMask.
+ */
+void lcd_copy_raster(const uint32_t* source, const uint8_t* mask);
+
+/**
+ * @brief Same as lcd_copy_raster(), with the source resampled: line y of the target takes
+ * pixel x from line source_rows[y], column source_columns[x] of the source. Source lines
+ * outside the raster are not copied.
+ */
+void lcd_copy_raster_scaled(const uint32_t* source, const int16_t* source_rows, const int16_t* source_columns,
+                            const uint8_t* mask);
+
+/**
+ * @brief Limits drawing from the calling thread to lines first to first + count - 1 of the
+ * raster, so host threads can each draw a band of the frame. lcd_update_strips() sets it to
+ * each strip in turn.
+ */
+void lcd_set_clip_lines(int first, int count);
+
+/**
+ * @brief Returns the framebuffer lines drawing currently lands in: all of them, the strip
+ * being drawn by lcd_update_strips() or the band set by lcd_set_clip_lines().
+ */
+void lcd_get_raster_lines(int* first, int* count);
+
 /**
  * @brief Updates a single pixel in the local framebuffer.
  * @param x X coordinate (0 to LCD_WIDTH-1).
@@ -24,6 +153,15 @@ void lcd_clear();
  */
 void lcd_draw_pixel(int x, int y, int color);
 
+#if LCD_STRIP_LINES == 0
+/**
+ * @brief Copies a line of the local framebuffer in the byte order it is sent to the panel.
+ * @param y Line (0 to LCD_HEIGHT-1).
+ * @param out LCD_WIDTH / 8 bytes, leftmost pixel in the most significant bit.
+ */
+void lcd_read_line(int y, uint8_t* out);
+#endif
+
 /**
  * @brief Fills the local framebuffer with a single color (0 for white, 1 for black).
  * @param color The color to fill (0 or 1).
@@ -31,3 +169,33 @@ void lcd_draw_pixel(int x, int y, int color);
 void lcd_fill_buffer(int color);
 
 void lcd_fill_line(int line, uint8_t pattern, int color);
+
+/**
+ * @brief Sets pixels x0 to x1 - 1 of a line in the local framebuffer to one color. Whole
+ * words in the middle of the span are stored at once, only the first and last word are
+ * masked. The span is clipped to the screen.
+ * @param y Line (0 to LCD_HEIGHT-1).
+ * @param x0 First pixel of the span.
+ * @param x1 Pixel right after the span.
+ * @param color Color (1 for black/set, 0 for white/clear).
+ */
+void lcd_fill_span(int y, int x0, int x1, int color);
+
+/**
+ * @brief Same as lcd_fill_span(), only touching the pixels set in pattern, which repeats
+ * every 8 pixels (leftmost pixel in the most significant bit) like in lcd_fill_line().
+ */
+void lcd_fill_span_pattern(int y, int x0, int x1, uint8_t pattern, int color);
+
+/**
+ * @brief Changes up to 32 pixels of a line in the local framebuffer, starting at x. Bit 31
+ * of each argument is pixel x, bit 30 pixel x + 1 and so on; pixels are cleared, then set,
+ * then toggled. Covers every raster op of a 1-bpp blit with at most two word writes. Pixels
+ * off the screen are dropped.
+ * @param y Line (0 to LCD_HEIGHT-1).
+ * @param x First pixel, may be negative.
+ * @param set Pixels to set to 1.
+ * @param clear Pixels to set to 0.
+ * @param toggle Pixels to invert.
+ */
+void lcd_write_bits(int y, int x, uint32_t set, uint32_t clear, uint32_t toggle);
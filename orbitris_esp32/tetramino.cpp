@@ -150,7 +150,49 @@ Tetramino* get_random_block() {
   return Blocks[get_random_value(0, ARR_SIZE(Blocks) - 1)];
 }
 
+// Tile sprites for every size the line delete animation shrinks a tile to, in two
+// variants: the checkerboard inside a tile follows the parity of x + y on the screen
+static uint8_t tile_data[TILE_W + 1][2][TILE_H];
+static uint8_t tile_mask[TILE_W + 1][2][TILE_H];
+static Sprite tile_sprites[TILE_W + 1][2];
+
+/**
+ * @brief Renders the tile sprites: black outline, black checkerboard over the background
+ * and white corners.
+ */
+void init_tile_sprites() {
+  for (int size = 0; size <= TILE_W; size++) {
+    for (int parity = 0; parity < 2; parity++) {
+      uint8_t* data = tile_data[size][parity];
+      uint8_t* mask = tile_mask[size][parity];
+      for (int row = 0; row < size; row++) {
+        for (int col = 0; col < size; col++) {
+          uint8_t bit = 0x80 >> col;
+          bool edge = row == 0 || row == size - 1 || col == 0 || col == size - 1;
+          bool corner = (row == 0 || row == size - 1) && (col == 0 || col == size - 1);
+          if (edge || ((row + col + parity) & 1)) {
+            mask[row] |= bit;
+          }
+          if (corner) {
+            data[row] |= bit;
+          }
+        }
+      }
+      tile_sprites[size][parity] = { (uint16_t)size, (uint16_t)size, data, mask };
+    }
+  }
+}
+
+const Sprite& get_tile_sprite(int x, int y, int size) {
+  return tile_sprites[size][(x + y) & 1];
+}
+
 void draw_tile(int x, int y, int size) {
+  if (size >= 0 && size <= TILE_W && !is_scaling()) {
+    draw_sprite(get_tile_sprite(x, y, size), x, y, BlitOp::MASKED);
+    return;
+  }
+
   draw_rectangle_lines(x, y, size, size, 0);
   draw_rectangle_checkerboard(x, y, size, size);
   draw_pixel(x, y, 1);
@@ -180,3 +222,13 @@ void draw_tetramino(const ActiveTetramino& tetramino) {
     }
   }
 }
+
+Rectangle get_tetramino_rect(const ActiveTetramino& tetramino) {
+  if (tetramino.block == nullptr) {
+    return {};
+  }
+
+  float startX = tetramino.pos.x - tetramino.block->center.x * TILE_W;
+  float startY = tetramino.pos.y - tetramino.block->center.y * TILE_H;
+  return { startX - 1, startY - 1, BLOCK_SIZE * TILE_W + 2, BLOCK_SIZE * TILE_H + 2 };
+}
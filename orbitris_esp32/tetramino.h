@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "draw.h"
 #include "game_utils.h"
 
 constexpr int BLOCK_SIZE = 4;
@@ -34,6 +35,23 @@ extern Tetramino* Blocks[];
 
 Tetramino* get_random_block();
 
+/**
+ * @brief Pre-renders the tile sprites drawn by draw_tile(), call once at startup before any
+ * Tilemap is created.
+ */
+void init_tile_sprites();
+
+/**
+ * @brief Returns the sprite draw_tile() draws unscaled for a tile of the given size at x, y.
+ */
+const Sprite& get_tile_sprite(int x, int y, int size);
+
 void draw_tile(int x, int y, int size);
 
 void draw_tetramino(const ActiveTetramino& tetramino);
+
+/**
+ * @brief Returns the screen area draw_tetramino() draws in, with a pixel to spare for
+ * rounding, or an empty rectangle without a block.
+ */
+Rectangle get_tetramino_rect(const ActiveTetramino& tetramino);
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <iterator>
 
 #include "const.h"
 #include "draw.h"
@@ -15,10 +16,33 @@ constexpr int tileMapWidth = TILES_X * TILE_W;
 constexpr int tileMapHeight = TILES_Y * TILE_H;
 constexpr Rectangle tileMapRect = { tileMapPosX, tileMapPosY, tileMapWidth, tileMapHeight };
 
+// A row of tiles takes one byte per tile in the layer
+static_assert(TILE_W == 8, "layer cells must be one byte wide");
+
+struct BoundaryRect {
+  int x, y, width, height;
+  uint8_t pattern_size;
+  uint8_t pattern;
+};
+
+// Top left corner of the boundary layer, the death area holds all the boundaries
+constexpr int boundaryLayerX = CENTER_X - DEATH_LENGTH * TILE_W / 2;
+constexpr int boundaryLayerY = CENTER_Y - DEATH_LENGTH * TILE_H / 2;
+
+// What GameScreen draws around the row and death areas outside of the game over animation,
+// in drawing order
+constexpr BoundaryRect boundaryRects[] = {
+  { CENTER_X - ROW_LENGTH * TILE_W / 2, CENTER_Y - ROW_LENGTH * TILE_H / 2, ROW_LENGTH * TILE_W, ROW_LENGTH * TILE_H,
+    ROW_BOUNDARY_PATTERN_SIZE, ROW_BOUNDARY_PATTERN },
+  { CENTER_X - DEATH_LENGTH * TILE_W / 2, CENTER_Y - DEATH_LENGTH * TILE_H / 2, DEATH_LENGTH * TILE_W, DEATH_LENGTH * TILE_H,
+    DEATH_BOUNDARY_PATTERN_SIZE, DEATH_BOUNDARY_PATTERN },
+};
+
 // Update logic constants
 constexpr float deleteProgressSpeed = 0.5f;
 
 Tilemap::Tilemap() {
+  render_boundary_layer();
   init();
 }
 
@@ -36,9 +60,12 @@ void Tilemap::init() {
   }
 
   tile_delete_info_ = {};
+  update_layer(true);
 }
 
 void Tilemap::update() {
+  // Only the line delete animation changes the board here
+  bool changing = tile_delete_info_.populated;
   if (tile_delete_info_.populated) {
     if (tile_delete_info_.draw_size > 0) {
       tile_delete_info_.draw_size -= deleteProgressSpeed;
@@ -52,6 +79,10 @@ void Tilemap::update() {
     tile_delete_info_.should_delete = false;
     tile_delete_info_.populated = false;
   }
+
+  if (changing) {
+    update_layer(false);
+  }
 }
 
 void Tilemap::draw() const {
@@ -61,11 +92,7 @@ void Tilemap::draw() const {
         continue;
       }
 
-      size_t size = TILE_W;
-      if (tilemap_[i][j].flags == TileFlags::TO_DELETE) {
-        size = std::max((size_t)0, (size_t)tile_delete_info_.draw_size);
-      }
-
+      size_t size = get_tile_size(tilemap_[i][j]);
       int posX = (i - TILES_X / 2) * TILE_W + CENTER_X + (TILE_W - size) / 2;
       int posY = (j - TILES_Y / 2) * TILE_H + CENTER_Y + (TILE_H - size) / 2;
       draw_tile(posX, posY, size);
@@ -73,6 +100,21 @@ void Tilemap::draw() const {
   }
 }
 
+void Tilemap::draw_layer() const {
+  for (int i = 0; i < layer_run_count_; i++) {
+    draw_sprite(layer_runs_[i], tileMapPosX, tileMapPosY + layer_run_rows_[i] * TILE_H, BlitOp::MASKED);
+  }
+}
+
+void Tilemap::collect_dirty_rect(Rectangle& dirty) {
+  dirty = get_union_rec(dirty, dirty_rect_);
+  dirty_rect_ = {};
+}
+
+void Tilemap::draw_boundary_layer() const {
+  draw_sprite(boundary_layer_, boundaryLayerX, boundaryLayerY, BlitOp::MASKED);
+}
+
 Rectangle Tilemap::intersect_tiles(const ActiveTetramino& block) {
   // TODO: optimize and check collisions only with tiles surrounding the
   // tilemap. Or don't do that, it should work just fine as-is
@@ -136,6 +178,7 @@ void Tilemap::place_tetramino(const ActiveTetramino& block) {
 
   check_rows();
   check_bounds();
+  update_layer(false);
 }
 
 bool Tilemap::can_move(const ActiveTetramino& block, int dx, int dy) const {
@@ -384,3 +427,124 @@ void Tilemap::delete_tiles_for_real() {
 bool Tilemap::is_blank(const Tile& tile) const {
   return !tile.occupied;
 }
+
+uint8_t Tilemap::get_tile_size(const Tile& tile) const {
+  if (is_blank(tile)) {
+    return LAYER_NO_TILE;
+  }
+
+  if (tile.flags == TileFlags::TO_DELETE) {
+    return std::max((size_t)0, (size_t)tile_delete_info_.draw_size);
+  }
+
+  return TILE_W;
+}
+
+void Tilemap::update_layer(bool all) {
+  bool changed = false;
+  for (int i = 0; i < TILES_X; i++) {
+    for (int j = 0; j < TILES_Y; j++) {
+      uint8_t size = get_tile_size(tilemap_[i][j]);
+      if (all || size != layer_sizes_[i][j]) {
+        render_layer_cell(i, j, size);
+        layer_sizes_[i][j] = size;
+        changed = true;
+
+        Rectangle cell = { (float)(tileMapPosX + i * TILE_W), (float)(tileMapPosY + j * TILE_H), TILE_W, TILE_H };
+        dirty_rect_ = get_union_rec(dirty_rect_, cell);
+      }
+    }
+  }
+
+  if (changed) {
+    update_layer_runs();
+  }
+}
+
+void Tilemap::update_layer_runs() {
+  layer_run_count_ = 0;
+  int run_start = -1;
+  for (int j = 0; j <= TILES_Y; j++) {
+    bool empty = true;
+    for (int row = j * TILE_H; row < (j + 1) * TILE_H && row < tileMapHeight && empty; row++) {
+      for (int byte = 0; byte < LAYER_ROW_BYTES && empty; byte++) {
+        empty = layer_mask_[row][byte] == 0;
+      }
+    }
+
+    if (!empty && run_start < 0) {
+      run_start = j;
+    } else if (empty && run_start >= 0) {
+      layer_runs_[layer_run_count_] = { tileMapWidth, (uint16_t)((j - run_start) * TILE_H),
+                                        layer_data_[run_start * TILE_H], layer_mask_[run_start * TILE_H] };
+      layer_run_rows_[layer_run_count_++] = run_start;
+      run_start = -1;
+    }
+  }
+}
+
+/**
+ * @brief Returns the color draw_rectangle_lines_pattern() leaves at x, y when drawing the
+ * boundaries, or -1 if it doesn't draw there.
+ */
+static int get_boundary_color(int x, int y) {
+  // Later rectangles and, within one, later sides are drawn over the earlier ones
+  for (int k = (int)std::size(boundaryRects) - 1; k >= 0; k--) {
+    const BoundaryRect& r = boundaryRects[k];
+    int right = r.x + r.width - 1;
+    int bottom = r.y + r.height - 1;
+    bool on_column = y >= r.y && y <= bottom;
+    bool on_row = x >= r.x && x <= right;
+
+    // Position along the outline, clockwise from the top left corner
+    int state = -1;
+    if (x == r.x && on_column) {
+      state = 2 * r.width + r.height + bottom - y;
+    } else if (y == bottom && on_row) {
+      state = r.width + r.height + right - x;
+    } else if (x == right && on_column) {
+      state = r.width + y - r.y;
+    } else if (y == r.y && on_row) {
+      state = x - r.x;
+    }
+
+    if (state >= 0) {
+      return (r.pattern >> (7 - state % r.pattern_size)) & 1;
+    }
+  }
+
+  return -1;
+}
+
+void Tilemap::render_layer_cell(int ix, int iy, uint8_t size) {
+  int cell_x = ix * TILE_W + tileMapPosX;
+  int cell_y = iy * TILE_H + tileMapPosY;
+  int offset = (TILE_W - size) / 2;
+  const Sprite* tile = size != LAYER_NO_TILE ? &get_tile_sprite(cell_x + offset, cell_y + offset, size) : nullptr;
+
+  for (int row = 0; row < TILE_H; row++) {
+    uint8_t data = 0;
+    uint8_t mask = 0;
+    if (tile != nullptr && row >= offset && row < offset + size) {
+      mask = tile->mask[row - offset] >> offset;
+      data = (tile->data[row - offset] >> offset) & mask;
+    }
+
+    layer_data_[iy * TILE_H + row][ix] = data;
+    layer_mask_[iy * TILE_H + row][ix] = mask;
+  }
+}
+
+void Tilemap::render_boundary_layer() {
+  for (int row = 0; row < DEATH_LENGTH * TILE_H; row++) {
+    for (int col = 0; col < DEATH_LENGTH * TILE_W; col++) {
+      int color = get_boundary_color(boundaryLayerX + col, boundaryLayerY + row);
+      if (color >= 0) {
+        boundary_mask_[row][col / 8] |= 0x80 >> col % 8;
+        boundary_data_[row][col / 8] |= color << (7 - col % 8);
+      }
+    }
+  }
+
+  boundary_layer_ = { DEATH_LENGTH * TILE_W, DEATH_LENGTH * TILE_H, boundary_data_[0], boundary_mask_[0] };
+}
@@ -10,6 +10,12 @@ constexpr auto TILES_Y = 20;
 constexpr auto ROW_LENGTH = 8;
 constexpr auto DEATH_LENGTH = 12;
 
+// Dashed outlines around the row and death areas, see draw_rectangle_lines_pattern()
+constexpr uint8_t ROW_BOUNDARY_PATTERN = 0xAA;  // 50%
+constexpr uint8_t ROW_BOUNDARY_PATTERN_SIZE = 8;
+constexpr uint8_t DEATH_BOUNDARY_PATTERN = 0xd8;  // 66%
+constexpr uint8_t DEATH_BOUNDARY_PATTERN_SIZE = 6;
+
 enum class TileFlags : uint8_t {
   NONE = 0,
   TO_DELETE,
@@ -43,6 +49,26 @@ public:
 
   void draw() const;
 
+  /**
+   * @brief Draws the tiles by blitting a layer pre-rendered from the board, one blit per run
+   * of rows that have anything in them. The layer is only re-rendered where tiles change,
+   * so this is cheaper than draw(), but it can't be scaled: use draw() under a scaling
+   * transform.
+   */
+  void draw_layer() const;
+
+  /**
+   * @brief Draws the row and death area boundaries at their full size in one blit of a
+   * layer rendered once. Unscaled only, like draw_layer(); the tetraminos go between the
+   * two.
+   */
+  void draw_boundary_layer() const;
+
+  /**
+   * @brief Adds the area of the tiles that changed since the last call to dirty.
+   */
+  void collect_dirty_rect(Rectangle& dirty);
+
   Rectangle intersect_tiles(const ActiveTetramino& block);
 
   void place_tetramino(const ActiveTetramino& block);
@@ -70,9 +96,27 @@ public:
   bool is_blank(int ix, int iy) const;
 
 private:
+  static constexpr int LAYER_ROW_BYTES = TILES_X * TILE_W / 8;
+  static constexpr int BOUNDARY_LAYER_ROW_BYTES = DEATH_LENGTH * TILE_W / 8;
+  static constexpr uint8_t LAYER_NO_TILE = 0xff;
+
   Tile tilemap_[TILES_Y][TILES_X]{};
   TileDeleteInfo tile_delete_info_{};
 
+  uint8_t layer_data_[TILES_Y * TILE_H][LAYER_ROW_BYTES]{};
+  uint8_t layer_mask_[TILES_Y * TILE_H][LAYER_ROW_BYTES]{};
+  // Runs of tile rows of the layer that aren't empty and the first tile row of each
+  Sprite layer_runs_[TILES_Y / 2]{};
+  int layer_run_rows_[TILES_Y / 2]{};
+  int layer_run_count_{};
+  // Tile size each cell of the layer was rendered with, LAYER_NO_TILE if empty
+  uint8_t layer_sizes_[TILES_X][TILES_Y]{};
+  // The boundaries only cover the death area
+  uint8_t boundary_data_[DEATH_LENGTH * TILE_H][BOUNDARY_LAYER_ROW_BYTES]{};
+  uint8_t boundary_mask_[DEATH_LENGTH * TILE_H][BOUNDARY_LAYER_ROW_BYTES]{};
+  Sprite boundary_layer_{};
+  Rectangle dirty_rect_{};
+
   bool is_blank(const Tile& tile) const;
 
   void check_rows();
@@ -84,4 +128,18 @@ private:
   void get_tetramino_tilemap_pos(const ActiveTetramino& block, int (*coords)[2]) const;
 
   void delete_tiles_for_real();
+
+  uint8_t get_tile_size(const Tile& tile) const;
+
+  /**
+   * @brief Re-renders the cells of the layer whose tile changed since they were rendered,
+   * or all of them.
+   */
+  void update_layer(bool all);
+
+  void update_layer_runs();
+
+  void render_layer_cell(int ix, int iy, uint8_t size);
+
+  void render_boundary_layer();
 };
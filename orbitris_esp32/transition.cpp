@@ -1,5 +1,8 @@
 #include "transition.h"
 
+#include <algorithm>
+
+#include "const.h"
 #include "draw.h"
 #include "game_utils.h"
 
@@ -30,6 +33,8 @@ static void draw_tarnsition_zoom_in();
 
 static void draw_transition_dissolve();
 
+static void draw_transition_slide();
+
 static void draw_transition_none();
 
 Screen* transition_from_screen = nullptr;
@@ -38,6 +43,13 @@ Screen* transition_to_screen = nullptr;
 static float transition_progress = 0.0f;
 static TransitionParams transition_params;
 
+// Snapshot of the old screen, taken once by prepare_transition_frame() and scaled for
+// every frame of the transition. In strip mode the surface only holds one strip, so the
+// old screen is drawn into it at the frame's zoom every time instead. Allocated once by
+// init_transitions(), nullptr if that failed.
+static Surface* transition_surface = nullptr;
+static bool has_snapshot = false;
+
 void (*draw_transition)();
 
 size_t get_masks_count() {
@@ -48,11 +60,18 @@ DrawMask get_mask(size_t index) {
   return MASKS[index];
 }
 
+void init_transitions() {
+  if (!transition_surface) {
+    transition_surface = create_surface();
+  }
+}
+
 void start_transition(Screen* from, Screen* to, TransitionParams params) {
   transition_from_screen = from;
   transition_to_screen = to;
   transition_progress = 0.0f;
   transition_params = params;
+  has_snapshot = false;
 
   // Init new state when transition begins
   transition_to_screen->init();
@@ -67,6 +86,11 @@ void start_transition(Screen* from, Screen* to, TransitionParams params) {
     case TransitionKind::DISSOLVE:
       draw_transition = draw_transition_dissolve;
       break;
+    case TransitionKind::SLIDE_DOWN:
+      // Starts out of view, the first frame is drawn before the first update
+      set_screen_offset(-LCD_HEIGHT, 0);
+      draw_transition = draw_transition_slide;
+      break;
     case TransitionKind::NONE:
     default:
       draw_transition = draw_transition_none;
@@ -79,8 +103,16 @@ bool update_transition() {
 
   transition_to_screen->update();
 
+  if (transition_params.kind == TransitionKind::SLIDE_DOWN) {
+    // Only the new screen is drawn, the display moves it and the panel keeps showing
+    // the old screen where the new one hasn't arrived yet
+    float ease_progress = ease_out_cubic(std::min(transition_progress, 1.0f));
+    set_screen_offset((int)((ease_progress - 1.0f) * LCD_HEIGHT), 0);
+  }
+
   if (transition_progress >= 1.0f) {
     // Called only when transition ends
+    has_snapshot = false;
     transition_from_screen->close();
     transition_from_screen = transition_to_screen;
     transition_to_screen = nullptr;
@@ -90,22 +122,97 @@ bool update_transition() {
   return false;
 }
 
+static bool is_mask_filled(const DrawMask& mask, uint8_t value) {
+  for (uint8_t row : mask.mask) {
+    if (row != value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void draw_screen_zoomed(Screen* screen, float zoom) {
+  push_transform();
+  scale_transform(to_fixed(zoom));
+  screen->draw_with_underlay();
+  pop_transform();
+}
+
+void prepare_transition_frame() {
+  bool shows_old = transition_params.kind == TransitionKind::ZOOM_IN ||
+                   transition_params.kind == TransitionKind::ZOOM_OUT ||
+                   transition_params.kind == TransitionKind::DISSOLVE;
+  if (has_snapshot || !shows_old || !transition_surface || !transition_surface->whole_screen) {
+    return;
+  }
+
+  // Drawn right away, so replays of the frame only ever read the finished snapshot,
+  // even with several threads each drawing a band. The old screen isn't updated
+  // anymore, so it stays valid. The surface still holds the last snapshot, so a screen
+  // that draws over its underlay gets the underlay redrawn first.
+  bool redraw_underlays = is_redrawing_underlays();
+  set_redraw_underlays(true);
+  begin_surface(*transition_surface);
+  draw_screen_zoomed(transition_from_screen, 1.0f);
+  end_surface();
+  set_redraw_underlays(redraw_underlays);
+  has_snapshot = true;
+}
+
+/**
+ * @brief Draws the new screen at new_zoom and, over it, the old one at old_zoom where
+ * new_mask is clear. The old screen is a snapshot scaled word-wise into place, so its
+ * cost doesn't depend on what it shows, and neither screen goes through the per-pixel
+ * mask. A screen the mask hides completely isn't drawn.
+ */
+static void draw_masked_screens(float old_zoom, float new_zoom, DrawMask new_mask) {
+  bool show_new = !is_mask_filled(new_mask, 0x00);
+  bool show_old = !is_mask_filled(new_mask, 0xff);
+
+  if (show_new) {
+    draw_screen_zoomed(transition_to_screen, new_zoom);
+  }
+
+  if (!show_old) {
+    return;
+  }
+
+  if (!transition_surface) {
+    // Without a surface the old screen goes through the per-pixel mask
+    begin_mask(~new_mask);
+    draw_screen_zoomed(transition_from_screen, old_zoom);
+    end_mask();
+    return;
+  }
+
+  if (!has_snapshot) {
+    begin_surface(*transition_surface);
+    draw_screen_zoomed(transition_from_screen, old_zoom);
+    end_surface();
+  }
+
+  begin_mask(~new_mask);
+  push_transform();
+  if (has_snapshot) {
+    scale_transform(to_fixed(old_zoom));
+  }
+  draw_surface(*transition_surface);
+  pop_transform();
+  end_mask();
+}
+
 static void draw_transition_none() {
-  transition_to_screen->draw();
+  transition_to_screen->draw_with_underlay();
 }
 
 static void draw_transition_dissolve() {
   float ease_progress = ease_out_cubic(transition_progress);
   int mask_index = (int)remap(ease_progress, 0.0f, 1.0f, 0.0f, MASKS_COUNT - 1);
-  DrawMask new_mask = MASKS[mask_index];
-  DrawMask old_mask = ~new_mask;
-  begin_mask(old_mask);
-  transition_from_screen->draw();
-  end_mask();
-  end_screen_scale();
-  begin_mask(new_mask);
-  transition_to_screen->draw();
-  end_mask();
+  draw_masked_screens(1.0f, 1.0f, MASKS[mask_index]);
+}
+
+static void draw_transition_slide() {
+  transition_to_screen->draw_with_underlay();
 }
 
 static void draw_tarnsition_zoom_in() {
@@ -117,19 +224,7 @@ static void draw_tarnsition_zoom_in() {
   float zoom_new = my_lerp(zoom_start_new, 1.0f, ease_progress);
 
   int mask_index = (int)remap(ease_progress, 0.0f, 1.0f, 0.0f, MASKS_COUNT - 1);
-  DrawMask new_mask = MASKS[mask_index];
-  DrawMask old_mask = ~new_mask;
-
-  begin_screen_scale(zoom_old);
-  begin_mask(old_mask);
-  transition_from_screen->draw();
-  end_mask();
-  end_screen_scale();
-  begin_screen_scale(zoom_new);
-  begin_mask(new_mask);
-  transition_to_screen->draw();
-  end_mask();
-  end_screen_scale();
+  draw_masked_screens(zoom_old, zoom_new, MASKS[mask_index]);
 }
 
 static void draw_tarnsition_zoom_out() {
@@ -141,17 +236,5 @@ static void draw_tarnsition_zoom_out() {
   float zoom_new = my_lerp(zoom_start_new, 1.0f, ease_progress);
 
   int mask_index = (int)remap(ease_progress, 0.0f, 1.0f, 0.0f, MASKS_COUNT - 1);
-  DrawMask new_mask = MASKS[mask_index];
-  DrawMask old_mask = ~new_mask;
-
-  begin_screen_scale(zoom_old);
-  begin_mask(old_mask);
-  transition_from_screen->draw();
-  end_mask();
-  end_screen_scale();
-  begin_screen_scale(zoom_new);
-  begin_mask(new_mask);
-  transition_to_screen->draw();
-  end_mask();
-  end_screen_scale();
+  draw_masked_screens(zoom_old, zoom_new, MASKS[mask_index]);
 }
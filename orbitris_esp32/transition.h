@@ -12,6 +12,7 @@ enum class TransitionKind {
   ZOOM_IN,
   ZOOM_OUT,
   DISSOLVE,
+  SLIDE_DOWN,  // new screen slides down over the old one, moved by the display
   NONE
 };
 
@@ -24,6 +25,11 @@ size_t get_masks_count();
 
 DrawMask get_mask(size_t index);
 
+/**
+ * @brief Allocates what transitions draw with, once for the whole game.
+ */
+void init_transitions();
+
 void start_transition(Screen* from, Screen* to, TransitionParams params);
 
 /**
@@ -33,4 +39,11 @@ void start_transition(Screen* from, Screen* to, TransitionParams params);
  */
 bool update_transition();
 
+/**
+ * @brief Draws what the transition needs before the frame itself, outside the display
+ * list: the snapshot of the old screen. Called after the frame's update, before the frame
+ * is recorded or drawn.
+ */
+void prepare_transition_frame();
+
 extern void (*draw_transition)();
@@ -1,22 +1,202 @@
-#include "raylib.h"
+#include "lcd_raylib.h"
 
-#include "../orbitris_esp32/const.h"
 #include <cstdint>
 
-extern RenderTexture2D target;
+#include "../orbitris_esp32/const.h"
+#include "../orbitris_esp32/sharp_display.h"
+
+// 1-bpp framebuffer in the device raster format: LCD_LINE_WORDS words per line,
+// leftmost pixel in the most significant bit, 1 for white. Drawing only touches
+// memory, the whole buffer is expanded and uploaded once per frame.
+
+static uint32_t framebuffer[LCD_LINE_WORDS * LCD_HEIGHT];
+// Lines clip_y0 to clip_y1 - 1 take drawing from this thread, see lcd_set_clip_lines()
+static DRAW_THREAD_LOCAL int clip_y0 = 0;
+static DRAW_THREAD_LOCAL int clip_y1 = LCD_HEIGHT;
+// Drawing goes to the framebuffer or a surface set by lcd_set_target()
+static DRAW_THREAD_LOCAL uint32_t* draw_target = framebuffer;
+static uint8_t pixels[LCD_WIDTH * LCD_HEIGHT];  // grayscale, one byte per pixel
+static Texture2D texture;
+
+// Same as on the device: line y is shown on line y + viewport_dy, moved right by
+// viewport_dx bytes, and lines nothing lands on keep their pixels
+static int viewport_dy = 0;
+static int viewport_dx = 0;
+
+Texture2D lcd_texture_init() {
+  Image image = {pixels, LCD_WIDTH, LCD_HEIGHT, 1, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+  texture = LoadTextureFromImage(image);
+  SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+  return texture;
+}
+
+void lcd_texture_update() {
+  const int dx = viewport_dx * 8;
+  for (int y = 0; y < LCD_HEIGHT; y++) {
+    int panel_y = y + viewport_dy;
+    if (panel_y < 0 || panel_y >= LCD_HEIGHT) {
+      continue;
+    }
+
+    const uint32_t* line = &framebuffer[y * LCD_LINE_WORDS];
+    uint8_t* out = &pixels[panel_y * LCD_WIDTH];
+    for (int panel_x = 0; panel_x < LCD_WIDTH; panel_x++) {
+      int x = panel_x - dx;
+      bool white = x < 0 || x >= LCD_WIDTH || ((line[x >> 5] << (x & 31)) & 0x80000000u);
+      out[panel_x] = white ? 0xff : 0x00;
+    }
+  }
+  UpdateTexture(texture, pixels);
+}
+
+void lcd_set_viewport(int dy, int dx_bytes) {
+  viewport_dy = dy;
+  viewport_dx = dx_bytes;
+}
+
+void lcd_texture_unload() {
+  UnloadTexture(texture);
+}
+
+void lcd_read_line(int y, uint8_t* out) {
+  const uint32_t* line = &framebuffer[y * LCD_LINE_WORDS];
+  for (int x = 0; x < LCD_WIDTH / 8; x++) {
+    out[x] = line[x >> 2] >> (24 - (x & 3) * 8);
+  }
+}
+
+int lcd_raster_words() {
+  return LCD_LINE_WORDS * LCD_HEIGHT;
+}
+
+void lcd_set_target(uint32_t* raster) {
+  draw_target = raster ? raster : framebuffer;
+}
+
+void lcd_copy_raster(const uint32_t* source, const uint8_t* mask) {
+  for (int y = clip_y0; y < clip_y1; y++) {
+    uint32_t* line = &draw_target[y * LCD_LINE_WORDS];
+    const uint32_t* from = &source[y * LCD_LINE_WORDS];
+    uint32_t pattern = mask[y & 7] * 0x01010101u;
+    if (pattern == 0) {
+      continue;
+    }
+
+    for (int x = 0; x < LCD_LINE_WORDS; x++) {
+      line[x] = (line[x] & ~pattern) | (from[x] & pattern);
+    }
+  }
+}
+
+void lcd_copy_raster_scaled(const uint32_t* source, const int16_t* source_rows, const int16_t* source_columns,
+                            const uint8_t* mask) {
+  for (int y = clip_y0; y < clip_y1; y++) {
+    uint32_t pattern = mask[y & 7] * 0x01010101u;
+    if (pattern == 0) {
+      continue;
+    }
+
+    const uint32_t* from = &source[source_rows[y] * LCD_LINE_WORDS];
+    uint32_t* line = &draw_target[y * LCD_LINE_WORDS];
+    for (int x = 0; x < LCD_WIDTH; x++) {
+      uint32_t bit = 0x80000000u >> (x & 31);
+      if (!(pattern & bit)) {
+        continue;
+      }
+
+      int source_x = source_columns[x];
+      bool white = (from[source_x >> 5] << (source_x & 31)) & 0x80000000u;
+      line[x >> 5] = white ? line[x >> 5] | bit : line[x >> 5] & ~bit;
+    }
+  }
+}
+
+void lcd_set_clip_lines(int first, int count) {
+  clip_y0 = first < 0 ? 0 : first;
+  clip_y1 = first + count > LCD_HEIGHT ? LCD_HEIGHT : first + count;
+  clip_y1 = clip_y1 < clip_y0 ? clip_y0 : clip_y1;
+}
+
+void lcd_get_raster_lines(int* first, int* count) {
+  *first = clip_y0;
+  *count = clip_y1 - clip_y0;
+}
 
 void lcd_draw_pixel(int x, int y, int color) {
-  DrawPixel(x, y, color == 1 ? WHITE : BLACK);
+  if (x < 0 || x >= LCD_WIDTH || y < clip_y0 || y >= clip_y1) return;
+
+  uint32_t bit = 0x80000000u >> (x & 31);
+  uint32_t& word = draw_target[(y * LCD_LINE_WORDS) + (x >> 5)];
+  if (color == 1) {
+    word |= bit;
+  } else {
+    word &= ~bit;
+  }
 }
 
 void lcd_fill_buffer(int color) {
-  ClearBackground(color == 1 ? WHITE : BLACK);
+  for (int y = clip_y0; y < clip_y1; y++) {
+    uint32_t* line = &draw_target[y * LCD_LINE_WORDS];
+    for (int x = 0; x < LCD_LINE_WORDS; x++) {
+      line[x] = color == 1 ? ~0u : 0;
+    }
+    line[LCD_LINE_WORDS - 1] &= LCD_LAST_WORD_MASK;
+  }
 }
 
 void lcd_fill_line(int line, uint8_t pattern, int color) {
-  for (int i = 0; i < LCD_WIDTH; i++) {
-    if (pattern & (0x80 >> (i & 7))) {
-      DrawPixel(i, line, color == 1 ? WHITE : BLACK);
+  if (line < clip_y0 || line >= clip_y1) return;
+
+  uint32_t* words = &draw_target[line * LCD_LINE_WORDS];
+  uint32_t mask = pattern * 0x01010101u;
+  for (int x = 0; x < LCD_LINE_WORDS; x++) {
+    uint32_t word_mask = (x == LCD_LINE_WORDS - 1) ? mask & LCD_LAST_WORD_MASK : mask;
+    if (color == 1) {
+      words[x] |= word_mask;
+    } else {
+      words[x] &= ~word_mask;
+    }
+  }
+}
+
+void lcd_fill_span_pattern(int y, int x0, int x1, uint8_t pattern, int color) {
+  if (y < clip_y0 || y >= clip_y1) return;
+  x0 = x0 < 0 ? 0 : x0;
+  x1 = x1 > LCD_WIDTH ? LCD_WIDTH : x1;
+  if (x0 >= x1) return;
+
+  uint32_t* words = &draw_target[y * LCD_LINE_WORDS];
+  uint32_t pattern_mask = pattern * 0x01010101u;
+  int last = (x1 - 1) >> 5;
+  for (int x = x0 >> 5; x <= last; x++) {
+    uint32_t mask = pattern_mask;
+    if (x == x0 >> 5) mask &= ~0u >> (x0 & 31);
+    if (x == last) mask &= ~0u << (31 - ((x1 - 1) & 31));
+    if (color == 1) {
+      words[x] |= mask;
+    } else {
+      words[x] &= ~mask;
     }
   }
 }
+
+void lcd_fill_span(int y, int x0, int x1, int color) {
+  lcd_fill_span_pattern(y, x0, x1, 0xff, color);
+}
+
+void lcd_write_bits(int y, int x, uint32_t set, uint32_t clear, uint32_t toggle) {
+  if (y < clip_y0 || y >= clip_y1 || x <= -32 || x >= LCD_WIDTH) return;
+
+  uint32_t* words = &draw_target[y * LCD_LINE_WORDS];
+  int word = (x + 32) / 32 - 1;
+  int shift = x & 31;
+  for (int i = 0; i < 2; i++, word++) {
+    if (word < 0 || word >= LCD_LINE_WORDS || (i == 1 && shift == 0)) continue;
+    uint32_t mask = word == LCD_LINE_WORDS - 1 ? LCD_LAST_WORD_MASK : ~0u;
+    int back = 32 - shift;
+    uint32_t s = (i == 0 ? set >> shift : set << back) & mask;
+    uint32_t c = (i == 0 ? clear >> shift : clear << back) & mask;
+    uint32_t t = (i == 0 ? toggle >> shift : toggle << back) & mask;
+    words[word] = ((words[word] & ~c) | s) ^ t;
+  }
+}
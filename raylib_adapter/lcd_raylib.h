@@ -0,0 +1,18 @@
+// Raylib stand-in for the panel: the framebuffer drawn by the lcd_* functions of
+// sharp_display.h is shown in a texture
+
+#pragma once
+
+#include "raylib.h"
+
+/**
+ * @brief Creates the texture the framebuffer is shown in. Needs the raylib window.
+ */
+Texture2D lcd_texture_init();
+
+/**
+ * @brief Uploads the framebuffer to the texture, moved by the viewport like the panel.
+ */
+void lcd_texture_update();
+
+void lcd_texture_unload();
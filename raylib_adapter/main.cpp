@@ -1,26 +1,53 @@
 #include "raylib.h"
 
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 #include "../orbitris_esp32/const.h"
 #include "../orbitris_esp32/game_main.h"
+#include "../orbitris_esp32/sharp_display.h"
+#include "../host/band_raster.h"
+#include "../host/frame_record.h"
+#include "lcd_raylib.h"
 
 constexpr auto WINDOW_SCALE = 3;
 
-RenderTexture2D target;
+Texture2D target;
+// Replays frames in bands on this many threads, see host/band_raster.h
+static int raster_threads = 1;
 
 void UpdateDrawFrame()
 {
-    BeginTextureMode(target);
-    update_draw_frame();
-    EndTextureMode();
+    // The game draws into the 1-bpp framebuffer, which goes to the GPU in one upload
+    if (raster_threads > 1)
+    {
+        update_frame();
+        record_draw_frame();
+        band_raster_draw();
+    }
+    else
+    {
+        update_draw_frame();
+    }
+    lcd_texture_update();
+
+    if (frame_recorder_is_open())
+    {
+        static uint8_t frame[FRAME_RECORD_SIZE];
+        for (int y = 0; y < LCD_HEIGHT; y++)
+        {
+            lcd_read_line(y, &frame[y * FRAME_RECORD_BYTES_PER_LINE]);
+        }
+        frame_recorder_add(frame);
+    }
 
     float scale = fmin((float)GetScreenWidth() / LCD_WIDTH, (float)GetScreenHeight() / LCD_HEIGHT);
-    Rectangle targetTextureRect = {0.0f, 0.0f, (float)LCD_WIDTH, (float)-LCD_HEIGHT};
+    Rectangle targetTextureRect = {0.0f, 0.0f, (float)LCD_WIDTH, (float)LCD_HEIGHT};
 
     BeginDrawing();
     ClearBackground(BLACK);
-    DrawTexturePro(target.texture, targetTextureRect,
+    DrawTexturePro(target, targetTextureRect,
                    {(GetScreenWidth() - ((float)LCD_WIDTH * scale)) * 0.5f, (GetScreenHeight() - ((float)LCD_HEIGHT * scale)) * 0.5f,
                     (float)LCD_WIDTH * scale, (float)LCD_HEIGHT * scale},
                    {0.0f, 0.0f}, 0.0f, WHITE);
@@ -29,13 +56,31 @@ void UpdateDrawFrame()
 
 int main(int argc, char const *argv[])
 {
+    // --record FILE captures every frame, see host/frame_record.h
+    // --threads N rasterizes frames on N threads
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc && !frame_recorder_open(argv[++i]))
+        {
+            TraceLog(LOG_ERROR, "Can't write %s", argv[i]);
+            return 1;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            raster_threads = atoi(argv[++i]);
+        }
+    }
+
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(LCD_WIDTH * WINDOW_SCALE, LCD_HEIGHT * WINDOW_SCALE, "Orbitris ESP32 adapted for Raylib");
 
-    target = LoadRenderTexture(LCD_WIDTH, LCD_HEIGHT);
-    SetTextureFilter(target.texture, TEXTURE_FILTER_POINT);
+    target = lcd_texture_init();
 
     init_game();
+    if (raster_threads > 1)
+    {
+        band_raster_init(raster_threads);
+    }
 
     SetTargetFPS(TARGET_FPS);
 
@@ -44,6 +89,13 @@ int main(int argc, char const *argv[])
         UpdateDrawFrame();
     }
 
+    if (frame_recorder_is_open() && !frame_recorder_close())
+    {
+        TraceLog(LOG_ERROR, "Recording is incomplete");
+    }
+
+    band_raster_shutdown();
+    lcd_texture_unload();
     CloseWindow();
 
     return 0;